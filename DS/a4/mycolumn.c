@@ -0,0 +1,334 @@
+/*
+ * Columnar binary record files with per-block zone maps.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "myrecord.h"
+#include "mystats.h"
+#include "mycolumn.h"
+
+static const char column_magic[8] = {'A', '4', 'C', 'O', 'L', 'M', 'N', '\n'};
+
+// slicing-by-8 tables: crc_table[k][b] is the CRC of byte b followed by k zero bytes
+static uint32_t crc_table[8][256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[0][i] = c;
+    }
+    for (int k = 1; k < 8; k++)
+        for (int i = 0; i < 256; i++)
+            crc_table[k][i] = crc_table[0][crc_table[k - 1][i] & 0xFF] ^ (crc_table[k - 1][i] >> 8);
+}
+
+// CRC-32 (IEEE) of len bytes, continuing from crc (0 to start); 8 bytes per step
+static uint32_t crc32_update(uint32_t crc, const void *data, size_t len) {
+    pthread_once(&crc_once, crc_init);
+    const unsigned char *p = data;
+    crc = ~crc;
+    for (; len >= 8; len -= 8, p += 8) {
+        uint32_t lo = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+        crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF]
+              ^ crc_table[5][(lo >> 16) & 0xFF] ^ crc_table[4][lo >> 24]
+              ^ crc_table[3][p[4]] ^ crc_table[2][p[5]]
+              ^ crc_table[1][p[6]] ^ crc_table[0][p[7]];
+    }
+    while (len--)
+        crc = crc_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static size_t pad4(size_t n) {
+    return (n + 3) & ~(size_t)3;
+}
+
+/**
+ * Write records as a column file: the score column, name offsets and names,
+ * then one zone map per block of COLUMN_BLOCK records. The header goes last,
+ * at the starting position, once every offset and checksum is known.
+ *
+ * @param *out - seekable output stream; the file starts at its position.
+ * @param *dataset - pointer to dataset array.
+ * @param n - the number of data record in dataset array.
+ * @return - 1 if successful; 0 on a write error or out of memory.
+ */
+int column_write(FILE *out, const RECORD *dataset, int n) {
+    if (!out || n < 0 || (n > 0 && !dataset)) return 0;
+    off_t start = ftello(out);
+    if (start < 0) return 0;
+
+    COLUMN_HEADER h;
+    memset(&h, 0, sizeof h);
+    memcpy(h.magic, column_magic, sizeof h.magic);
+    h.byte_order = 0x01020304u;
+    h.version = COLUMN_VERSION;
+    h.block_size = COLUMN_BLOCK;
+    h.nblocks = (uint32_t)((n + COLUMN_BLOCK - 1) / COLUMN_BLOCK);
+    h.count = (uint64_t)n;
+
+    int nb = (int)h.nblocks;
+    float *scores = malloc(((size_t)n + 1) * sizeof *scores);
+    uint32_t *offs = malloc(((size_t)n + 1) * sizeof *offs);
+    COLUMN_ZONE *zones = malloc(((size_t)nb + 1) * sizeof *zones);
+    int ok = scores && offs && zones;
+
+    if (ok) {
+        size_t at = 0;
+        for (int i = 0; i < n; i++) {
+            scores[i] = dataset[i].score;
+            offs[i] = (uint32_t)at;
+            at += strnlen(dataset[i].name, sizeof dataset[i].name) + 1;
+        }
+        offs[n] = (uint32_t)at;
+        h.blob_len = at;
+
+        for (int b = 0; b < nb; b++) {
+            int lo = b * COLUMN_BLOCK;
+            int hi = lo + COLUMN_BLOCK < n ? lo + COLUMN_BLOCK : n;
+            COLUMN_ZONE *z = &zones[b];
+            z->min = INFINITY;
+            z->max = -INFINITY;
+            for (int i = lo; i < hi; i++) {
+                if (scores[i] < z->min) z->min = scores[i];
+                if (scores[i] > z->max) z->max = scores[i];
+            }
+            z->crc = crc32_update(0, scores + lo, (size_t)(hi - lo) * sizeof *scores);
+        }
+
+        h.scores_off = sizeof h;
+        h.names_off = h.scores_off + (uint64_t)n * sizeof *scores;
+        h.blob_off = h.names_off + ((uint64_t)n + 1) * sizeof *offs;
+        h.zones_off = h.blob_off + pad4(h.blob_len);
+        h.names_crc = crc32_update(0, offs, ((size_t)n + 1) * sizeof *offs);
+
+        ok = fwrite(&h, sizeof h, 1, out) == 1
+             && fwrite(scores, sizeof *scores, n, out) == (size_t)n
+             && fwrite(offs, sizeof *offs, (size_t)n + 1, out) == (size_t)n + 1;
+        for (int i = 0; ok && i < n; i++) {
+            size_t len = offs[i + 1] - offs[i];
+            char name[sizeof dataset[i].name + 1];
+            memcpy(name, dataset[i].name, len - 1);
+            name[len - 1] = '\0';
+            h.names_crc = crc32_update(h.names_crc, name, len);
+            ok = fwrite(name, 1, len, out) == len;
+        }
+        static const char zero[4];
+        size_t pad = pad4(h.blob_len) - h.blob_len;
+        ok = ok && fwrite(zero, 1, pad, out) == pad
+             && fwrite(zones, sizeof *zones, nb, out) == (size_t)nb;
+    }
+
+    if (ok) {
+        h.header_crc = crc32_update(0, &h, offsetof(COLUMN_HEADER, header_crc));
+        off_t end = ftello(out);
+        ok = end >= 0 && fseeko(out, start, SEEK_SET) == 0
+             && fwrite(&h, sizeof h, 1, out) == 1
+             && fseeko(out, end, SEEK_SET) == 0
+             && fflush(out) == 0;
+    }
+
+    free(scores);
+    free(offs);
+    free(zones);
+    return ok;
+}
+
+/**
+ * Convert a CSV record file to a column file.
+ *
+ * @param *csv - record file in the import_data format.
+ * @param *out - seekable output stream.
+ * @return - 1 if successful; 0 on a read or write error or out of memory.
+ */
+int column_convert(FILE *csv, FILE *out) {
+    DATASET *ds = import_dataset(csv);
+    if (!ds) return 0;
+    int ok = column_write(out, ds->records, ds->count);
+    dataset_free(ds);
+    return ok;
+}
+
+/**
+ * Map a column file read-only. The header's magic, byte order, version,
+ * checksum and section bounds are checked; block and name checksums are
+ * left to column_verify so opening stays O(1).
+ *
+ * @param *fp - stream positioned at the start of the column file.
+ * @return - the mapped file, or NULL if it is not a valid column file or
+ *           memory runs out.
+ */
+COLFILE *column_open(FILE *fp) {
+    if (!fp) return NULL;
+    struct stat st;
+    off_t pos = ftello(fp);
+    int fd = fileno(fp);
+    if (pos < 0 || fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)
+        || st.st_size - pos < (off_t)sizeof(COLUMN_HEADER))
+        return NULL;
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return NULL;
+    const char *base = (const char *)map + pos;
+    uint64_t avail = (uint64_t)(st.st_size - pos);
+
+    COLUMN_HEADER h;
+    memcpy(&h, base, sizeof h);
+    uint64_t n = h.count;
+    int ok = memcmp(h.magic, column_magic, sizeof h.magic) == 0
+             && h.byte_order == 0x01020304u
+             && h.version == COLUMN_VERSION
+             && h.header_crc == crc32_update(0, &h, offsetof(COLUMN_HEADER, header_crc))
+             && n <= INT32_MAX && h.block_size > 0
+             && h.nblocks == (n + h.block_size - 1) / h.block_size
+             && h.blob_len <= avail
+             && h.scores_off == sizeof h
+             && h.names_off == h.scores_off + n * sizeof(float)
+             && h.blob_off == h.names_off + (n + 1) * sizeof(uint32_t)
+             && h.zones_off == h.blob_off + pad4(h.blob_len)
+             && h.zones_off + (uint64_t)h.nblocks * sizeof(COLUMN_ZONE) <= avail;
+
+    COLFILE *cf = ok ? calloc(1, sizeof *cf) : NULL;
+    if (!cf) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    cf->base = map;
+    cf->len = st.st_size;
+    cf->header = (const COLUMN_HEADER *)base;
+    cf->count = (int)n;
+    cf->block_size = (int)h.block_size;
+    cf->nblocks = (int)h.nblocks;
+    cf->scores = (const float *)(base + h.scores_off);
+    cf->name_off = (const uint32_t *)(base + h.names_off);
+    cf->names = base + h.blob_off;
+    cf->zones = (const COLUMN_ZONE *)(base + h.zones_off);
+    return cf;
+}
+
+/**
+ * Unmap a column file.
+ *
+ * @param *cf - column file, may be NULL.
+ */
+void column_close(COLFILE *cf) {
+    if (!cf) return;
+    munmap(cf->base, cf->len);
+    free(cf);
+}
+
+/**
+ * Check the checksum of every score block and of the names, and that the
+ * name offsets stay inside the name section.
+ *
+ * @param *cf - column file.
+ * @return - 1 if everything matches, 0 otherwise.
+ */
+int column_verify(const COLFILE *cf) {
+    const COLUMN_HEADER *h = cf->header;
+    for (int b = 0; b < cf->nblocks; b++) {
+        int lo = b * cf->block_size;
+        int len = cf->count - lo < cf->block_size ? cf->count - lo : cf->block_size;
+        if (crc32_update(0, cf->scores + lo, (size_t)len * sizeof(float)) != cf->zones[b].crc)
+            return 0;
+    }
+    uint32_t crc = crc32_update(0, cf->name_off, ((size_t)cf->count + 1) * sizeof *cf->name_off);
+    if (crc32_update(crc, cf->names, h->blob_len) != h->names_crc) return 0;
+
+    for (int i = 0; i < cf->count; i++) {
+        if (cf->name_off[i] >= cf->name_off[i + 1] || cf->name_off[i + 1] > h->blob_len
+            || cf->names[cf->name_off[i + 1] - 1] != '\0')
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * Name of a record.
+ *
+ * @param *cf - column file.
+ * @param i - record index, 0 <= i < count.
+ * @return - NUL-terminated name inside the mapping.
+ */
+const char *column_name(const COLFILE *cf, int i) {
+    return cf->names + cf->name_off[i];
+}
+
+/**
+ * process_data over the mapped score column: the moments reduce straight
+ * from the mapping; only the median needs a private copy to select in.
+ *
+ * @param *cf - column file.
+ * @return - stats value in STATS type; all zero if empty or out of memory.
+ */
+STATS column_stats(const COLFILE *cf) {
+    STATS stats = {0};
+    int n = cf->count;
+    if (n <= 0) return stats;
+
+    float *v = malloc((size_t)n * sizeof *v);
+    if (!v) return stats;
+    memcpy(v, cf->scores, (size_t)n * sizeof *v);
+
+    MOMENTS m = moments_parallel(cf->scores, n, 0);
+    stats.count = n;
+    stats.mean = (float)m.mean;
+    stats.stddev = (float)moments_stddev(&m);
+    stats.median = select_median(v, n);
+    free(v);
+    return stats;
+}
+
+/**
+ * grade_many over the mapped score column.
+ *
+ * @param *cf - column file.
+ * @param *grade_ids - output array of count ids into grade_scale_default.letters.
+ */
+void column_grades(const COLFILE *cf, uint8_t *grade_ids) {
+    grade_many(cf->scores, cf->count, grade_ids);
+}
+
+/**
+ * Find the records with lo <= score <= hi. Blocks whose zone map lies
+ * entirely outside the range are skipped without touching their scores, and
+ * blocks entirely inside it only need their NaNs left out.
+ *
+ * @param *cf - column file.
+ * @param lo, hi - score range, inclusive.
+ * @param *idx - output array with room for count indexes, in file order.
+ * @param *blocks_skipped - receives the number of blocks skipped; may be NULL.
+ * @return - number of records found.
+ */
+int column_filter(const COLFILE *cf, float lo, float hi, uint32_t *idx, int *blocks_skipped) {
+    int found = 0, skipped = 0;
+    for (int b = 0; b < cf->nblocks; b++) {
+        const COLUMN_ZONE *z = &cf->zones[b];
+        int first = b * cf->block_size;
+        int end = cf->count - first < cf->block_size ? cf->count : first + cf->block_size;
+
+        if (!(z->max >= lo && z->min <= hi)) {
+            skipped++;
+        } else if (z->min >= lo && z->max <= hi && z->min <= z->max) {
+            for (int i = first; i < end; i++)
+                if (cf->scores[i] == cf->scores[i]) idx[found++] = (uint32_t)i;
+        } else {
+            for (int i = first; i < end; i++)
+                if (cf->scores[i] >= lo && cf->scores[i] <= hi) idx[found++] = (uint32_t)i;
+        }
+    }
+    if (blocks_skipped) *blocks_skipped = skipped;
+    return found;
+}
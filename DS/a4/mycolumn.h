@@ -0,0 +1,82 @@
+/*
+ * Columnar binary record files with per-block zone maps.
+ */
+
+ #ifndef MYCOLUMN_H
+ #define MYCOLUMN_H
+
+ #include <stdio.h>
+ #include <stdint.h>
+ #include "myrecord.h"
+
+ #define COLUMN_BLOCK 4096
+ #define COLUMN_VERSION 1
+
+ /*
+  * File layout, all in the writer's byte order (checked on open):
+  *   header | scores: float[count] | name offsets: uint32[count + 1] |
+  *   names: NUL-terminated, padded to 4 bytes | zones: COLUMN_ZONE[nblocks]
+  * Block b holds records [b * block_size, (b + 1) * block_size). Checksums
+  * are CRC-32: one per block of scores, one over offsets and names, and one
+  * over the header itself.
+  */
+ typedef struct {
+   char magic[8];
+   uint32_t byte_order;      // 0x01020304 as written
+   uint32_t version;
+   uint32_t block_size;
+   uint32_t nblocks;
+   uint64_t count;
+   uint64_t scores_off, names_off, blob_off, zones_off;
+   uint64_t blob_len;
+   uint32_t names_crc;
+   uint32_t header_crc;      // over the bytes before this field
+ } COLUMN_HEADER;
+
+ // zone map of one block: score range (NaN excluded) and checksum
+ typedef struct {
+   float min, max;
+   uint32_t crc;
+ } COLUMN_ZONE;
+
+ // a column file mapped read-only; the arrays point into the mapping
+ typedef struct {
+   void *base;
+   size_t len;
+   const COLUMN_HEADER *header;
+   int count, block_size, nblocks;
+   const float *scores;
+   const uint32_t *name_off;
+   const char *names;
+   const COLUMN_ZONE *zones;
+ } COLFILE;
+
+ // write records as a column file to a seekable stream; 1 if successful
+ int column_write(FILE *out, const RECORD *dataset, int n);
+
+ // convert a CSV record file (import_data format) to a column file
+ int column_convert(FILE *csv, FILE *out);
+
+ // map a column file and check its header; NULL if invalid or out of memory
+ COLFILE *column_open(FILE *fp);
+
+ // unmap a column file
+ void column_close(COLFILE *cf);
+
+ // check every block and name checksum; 1 if all match
+ int column_verify(const COLFILE *cf);
+
+ // name of record i
+ const char *column_name(const COLFILE *cf, int i);
+
+ // process_data over the mapped score column
+ STATS column_stats(const COLFILE *cf);
+
+ // grade_many over the mapped score column
+ void column_grades(const COLFILE *cf, uint8_t *grade_ids);
+
+ // indexes of records with lo <= score <= hi, skipping blocks outside the
+ // range by their zone maps; returns the number found
+ int column_filter(const COLFILE *cf, float lo, float hi, uint32_t *idx, int *blocks_skipped);
+
+ #endif
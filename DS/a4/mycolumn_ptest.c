@@ -0,0 +1,107 @@
+/*
+--------------------------------------------------
+Project: a4
+File:    mycolumn_ptest.c
+About:   public test driver for mycolumn
+Version: 2026-10-18
+--------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "myrecord.h"
+#include "mycolumn.h"
+
+void test_column_convert() {
+	printf("------------------\n");
+	printf("Test: column_convert(marks.txt)\n\n");
+	FILE *csv = fopen("marks.txt", "r");
+	FILE *col = tmpfile();
+	if (csv == NULL || col == NULL) {
+		perror("open input file error");
+		return;
+	}
+	printf("column_convert(): %d\n", column_convert(csv, col));
+	rewind(csv);
+	RECORD dataset[100];
+	int count = import_data(csv, dataset);
+	fclose(csv);
+
+	rewind(col);
+	COLFILE *cf = column_open(col);
+	if (cf == NULL) {
+		printf("column_open(): invalid\n");
+		fclose(col);
+		return;
+	}
+	printf("column_open(): %d records, %d blocks\n", cf->count, cf->nblocks);
+	printf("column_verify(): %d\n", column_verify(cf));
+
+	int same = cf->count == count;
+	for (int i = 0; same && i < count; i++)
+		same = strcmp(column_name(cf, i), dataset[i].name) == 0 && cf->scores[i] == dataset[i].score;
+	printf("same records as import_data: %s\n", same ? "yes" : "no");
+
+	STATS a = column_stats(cf), b = process_data(dataset, count);
+	printf("column_stats: %d %.2f %.2f %.2f\n", a.count, a.mean, a.stddev, a.median);
+	printf("process_data: %d %.2f %.2f %.2f\n", b.count, b.mean, b.stddev, b.median);
+
+	uint8_t ids[100];
+	column_grades(cf, ids);
+	printf("grades:");
+	for (int i = 0; i < cf->count; i++)
+		printf(" %s", grade_scale_default.letters[ids[i]].letter_grade);
+	printf("\n");
+
+	column_close(cf);
+	fclose(col);
+	printf("\n");
+}
+
+void test_column_filter() {
+	printf("------------------\n");
+	printf("Test: column_filter\n\n");
+	// scores rise with the record index, so zone maps exclude most blocks
+	int n = 100000;
+	RECORD *dataset = malloc(n * sizeof *dataset);
+	uint32_t *idx = malloc(n * sizeof *idx);
+	FILE *col = tmpfile();
+	if (!dataset || !idx || !col) return;
+	for (int i = 0; i < n; i++) {
+		snprintf(dataset[i].name, sizeof dataset[i].name, "S%d", i);
+		dataset[i].score = i / 1000.0f;
+	}
+	column_write(col, dataset, n);
+	rewind(col);
+	COLFILE *cf = column_open(col);
+	if (cf) {
+		int skipped, found = column_filter(cf, 50.0f, 59.999f, idx, &skipped);
+		int expect = 0;
+		for (int i = 0; i < n; i++)
+			expect += dataset[i].score >= 50.0f && dataset[i].score <= 59.999f;
+		printf("column_filter([50, 59.999]): %d found (expected %d), %d of %d blocks skipped\n",
+				found, expect, skipped, cf->nblocks);
+		column_close(cf);
+	}
+
+	// flip one score byte: the header still opens, the block checksum fails
+	fseek(col, sizeof(COLUMN_HEADER) + 4 * 5000, SEEK_SET);
+	fputc(0x7f, col);
+	fflush(col);
+	rewind(col);
+	cf = column_open(col);
+	printf("after corruption, column_verify(): %d\n", cf ? column_verify(cf) : -1);
+	column_close(cf);
+
+	fclose(col);
+	free(dataset);
+	free(idx);
+	printf("\n");
+}
+
+int main(int argc, char *args[]) {
+	test_column_convert();
+	test_column_filter();
+	return 0;
+}
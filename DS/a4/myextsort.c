@@ -0,0 +1,321 @@
+/*
+ * External merge sort of record files that do not fit in memory.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include "myrecord.h"
+#include "mystats.h"
+#include "myextsort.h"
+
+// run buffer, sort permutation and radix scratch per record in memory
+#define BYTES_PER_RECORD 48
+// runs hold whole blocks of this many records so moments merge as in process_data
+#define RUN_BLOCK 4096
+#define MIN_MERGE_BLOCK 256
+
+typedef struct {
+    FILE *fp;
+    long long len;          // records in the run
+} RUN;
+
+typedef struct {
+    FILE *fp;
+    long long left;         // records not yet read into buf
+    RECORD *buf;
+    int pos, fill;          // buf[pos] is the current record, exhausted when pos == fill
+} CURSOR;
+
+/*
+ * Order-preserving unsigned key of a score, the same key the radix sorts
+ * use, so merged runs come out in exactly the order record_order gives.
+ */
+static uint32_t score_key(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof u);
+    return u ^ (uint32_t)(-(int32_t)(u >> 31) | 0x80000000u);
+}
+
+static void free_runs(RUN *runs, int n) {
+    for (int i = 0; i < n; i++)
+        if (runs[i].fp) fclose(runs[i].fp);
+    free(runs);
+}
+
+static int append_run(RUN **runs, int *n, int *cap, FILE *fp, long long len) {
+    if (*n == *cap) {
+        int c = *cap ? *cap * 2 : 16;
+        RUN *r = realloc(*runs, c * sizeof *r);
+        if (!r) return 0;
+        *runs = r;
+        *cap = c;
+    }
+    (*runs)[*n].fp = fp;
+    (*runs)[*n].len = len;
+    (*n)++;
+    return 1;
+}
+
+/*
+ * Phase 1: read the input a run at a time, accumulate its moments block by
+ * block, sort the run by decreasing score (stable) and spill it. The merge
+ * only matches report_data if every run is stably sorted, so a run that
+ * sort_records cannot sort for lack of memory fails the whole report.
+ */
+static int make_runs(FILE *in, int run_cap, RUN **runs, int *nruns, MOMENTS *m) {
+    RECORD *buf = malloc((size_t)run_cap * sizeof *buf);
+    int cap = 0, ok = buf != NULL;
+    float scores[RUN_BLOCK];
+
+    while (ok) {
+        int n = read_records(in, buf, run_cap);
+        if (n == 0) break;
+
+        for (int i = 0; i < n; i += RUN_BLOCK) {
+            int len = n - i < RUN_BLOCK ? n - i : RUN_BLOCK;
+            for (int j = 0; j < len; j++)
+                scores[j] = buf[i + j].score;
+            MOMENTS b = moments_of(scores, len);
+            moments_merge(m, &b);
+        }
+
+        FILE *fp = tmpfile();
+        ok = fp && sort_records(buf, n, 1)
+             && fwrite(buf, sizeof *buf, n, fp) == (size_t)n
+             && fflush(fp) == 0;
+        if (ok) ok = append_run(runs, nruns, &cap, fp, n);
+        if (!ok && fp) fclose(fp);
+    }
+
+    free(buf);
+    return ok;
+}
+
+static RECORD *cursor_record(const CURSOR *c) {
+    return &c->buf[c->pos];
+}
+
+// refill an exhausted cursor from its run; 0 on a read error
+static int cursor_fill(CURSOR *c, int block) {
+    c->pos = c->fill = 0;
+    if (c->left == 0) return 1;
+    int want = c->left < block ? (int)c->left : block;
+    if (fread(c->buf, sizeof *c->buf, want, c->fp) != (size_t)want) return 0;
+    c->fill = want;
+    c->left -= want;
+    return 1;
+}
+
+/*
+ * Whether run a's current record comes before run b's: higher score first,
+ * the earlier run on equal scores so the merge is stable. Exhausted runs
+ * lose; index k is the virtual leaf used to build the tree, which always wins.
+ */
+static int merge_wins(const CURSOR *c, int k, int a, int b) {
+    if (a == k) return 1;
+    if (b == k) return 0;
+    int ea = c[a].pos == c[a].fill, eb = c[b].pos == c[b].fill;
+    if (ea || eb) return eb && (!ea || a < b);
+    uint32_t x = score_key(cursor_record(&c[a])->score);
+    uint32_t y = score_key(cursor_record(&c[b])->score);
+    if (x != y) return x > y;
+    return a < b;
+}
+
+/*
+ * Replay the matches from leaf s to the root of the loser tree: each node
+ * keeps the loser and passes the winner up; tree[0] holds the overall winner.
+ */
+static void merge_adjust(int *tree, const CURSOR *c, int k, int s) {
+    for (int t = (s + k) / 2; t > 0; t /= 2) {
+        if (merge_wins(c, k, tree[t], s)) {
+            int w = tree[t];
+            tree[t] = s;
+            s = w;
+        }
+    }
+    tree[0] = s;
+}
+
+/*
+ * Phase 2: k-way merge of runs with a loser tree, log2(k) comparisons per
+ * record. Records go to bin as raw RECORDs, or to report as graded lines.
+ */
+static int merge_runs(RUN *runs, int k, size_t budget, FILE *bin, FILE *report) {
+    int block = (int)(budget / ((size_t)k * sizeof(RECORD)));
+    if (block < MIN_MERGE_BLOCK) block = MIN_MERGE_BLOCK;
+
+    CURSOR *c = calloc(k, sizeof *c);
+    int *tree = malloc((k + 1) * sizeof *tree);
+    RECORD *bufs = malloc((size_t)k * block * sizeof *bufs);
+    char *out = malloc(REPORT_BUFFER);
+    int ok = c && tree && bufs && out;
+
+    for (int i = 0; ok && i < k; i++) {
+        c[i].fp = runs[i].fp;
+        c[i].left = runs[i].len;
+        c[i].buf = bufs + (size_t)i * block;
+        ok = fseeko(c[i].fp, 0, SEEK_SET) == 0 && cursor_fill(&c[i], block);
+    }
+    if (ok) {
+        for (int t = 0; t <= k; t++) tree[t] = k;
+        for (int i = k - 1; i >= 0; i--) merge_adjust(tree, c, k, i);
+    }
+
+    char *p = out;
+    while (ok) {
+        int w = tree[0];
+        if (c[w].pos == c[w].fill) break;       // every run is exhausted
+
+        const RECORD *r = cursor_record(&c[w]);
+        if (report) {
+            p = format_record(p, r);
+            if (p > out + REPORT_BUFFER - REPORT_LINE_MAX) {
+                ok = fwrite(out, 1, p - out, report) == (size_t)(p - out);
+                p = out;
+            }
+        } else {
+            ok = fwrite(r, sizeof *r, 1, bin) == 1;
+        }
+
+        if (++c[w].pos == c[w].fill) ok = ok && cursor_fill(&c[w], block);
+        merge_adjust(tree, c, k, w);
+    }
+    if (ok && report && p > out)
+        ok = fwrite(out, 1, p - out, report) == (size_t)(p - out);
+
+    free(c);
+    free(tree);
+    free(bufs);
+    free(out);
+    return ok;
+}
+
+/*
+ * Merge groups of EXTSORT_MAX_FAN_IN runs into longer runs until the final
+ * merge can take them all at once.
+ */
+static int reduce_runs(RUN **runs, int *nruns, size_t budget) {
+    while (*nruns > EXTSORT_MAX_FAN_IN) {
+        RUN *next = NULL;
+        int n = 0, cap = 0, ok = 1;
+        for (int g = 0; ok && g < *nruns; g += EXTSORT_MAX_FAN_IN) {
+            int k = *nruns - g < EXTSORT_MAX_FAN_IN ? *nruns - g : EXTSORT_MAX_FAN_IN;
+            long long len = 0;
+            for (int i = 0; i < k; i++) len += (*runs)[g + i].len;
+
+            FILE *fp = tmpfile();
+            ok = fp && merge_runs(*runs + g, k, budget, fp, NULL) && fflush(fp) == 0;
+            if (ok) ok = append_run(&next, &n, &cap, fp, len);
+            if (!ok && fp) fclose(fp);
+        }
+        free_runs(*runs, *nruns);
+        *runs = next;
+        *nruns = n;
+        if (!ok) return 0;
+    }
+    return 1;
+}
+
+static int read_key(FILE *fp, long long i, uint32_t *key) {
+    RECORD r;
+    if (fseeko(fp, (off_t)(i * (long long)sizeof r), SEEK_SET) != 0
+        || fread(&r, sizeof r, 1, fp) != 1)
+        return 0;
+    *key = score_key(r.score);
+    return 1;
+}
+
+/*
+ * Number of records with key <= v in a run sorted by decreasing key: binary
+ * search for the first such record, one record read per step.
+ */
+static int count_le(const RUN *run, uint32_t v, long long *count) {
+    long long lo = 0, hi = run->len;
+    while (lo < hi) {
+        long long mid = lo + (hi - lo) / 2;
+        uint32_t key;
+        if (!read_key(run->fp, mid, &key)) return 0;
+        if (key <= v) hi = mid;
+        else lo = mid + 1;
+    }
+    *count += run->len - lo;
+    return 1;
+}
+
+/*
+ * The (rank + 1)-th smallest score over all runs, without merging them:
+ * binary search over the 2^32 keys for the smallest key that at least
+ * rank + 1 records do not exceed. Costs 32 * nruns * log2(run length) reads.
+ */
+static int select_rank(const RUN *runs, int nruns, long long rank, float *score) {
+    uint32_t lo = 0, hi = UINT32_MAX;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        long long count = 0;
+        for (int i = 0; i < nruns; i++)
+            if (!count_le(&runs[i], mid, &count)) return 0;
+        if (count >= rank + 1) hi = mid;
+        else lo = mid + 1;
+    }
+    uint32_t u = lo ^ ((lo >> 31) ? 0x80000000u : 0xFFFFFFFFu);
+    memcpy(score, &u, sizeof *score);
+    return 1;
+}
+
+/*
+ * Median as process_data computes it: the middle score, or the mean of the
+ * two middle scores when the count is even.
+ */
+static int runs_median(const RUN *runs, int nruns, long long n, float *median) {
+    if (!select_rank(runs, nruns, n / 2, median)) return 0;
+    if (n % 2 == 0) {
+        float lower;
+        if (!select_rank(runs, nruns, n / 2 - 1, &lower)) return 0;
+        *median = (lower + *median) / 2.0f;
+    }
+    return 1;
+}
+
+/**
+ * Write the report of report_data for a record file of any size within a
+ * memory budget.
+ *
+ * @param *in - record file, read from its current position.
+ * @param *out - report output.
+ * @param mem_budget - bytes of memory to use, 0 for EXTSORT_DEFAULT_BUDGET.
+ * @return - 1 if successful; 0 if there are no records, memory or temporary
+ *           files run out, or a read or write fails.
+ */
+int report_data_external(FILE *in, FILE *out, size_t mem_budget) {
+    if (!in || !out) return 0;
+    if (mem_budget == 0) mem_budget = EXTSORT_DEFAULT_BUDGET;
+
+    size_t cap = mem_budget / BYTES_PER_RECORD / RUN_BLOCK * RUN_BLOCK;
+    if (cap < RUN_BLOCK) cap = RUN_BLOCK;
+    if (cap > (size_t)INT32_MAX / 2) cap = (size_t)INT32_MAX / 2 / RUN_BLOCK * RUN_BLOCK;
+
+    RUN *runs = NULL;
+    int nruns = 0;
+    MOMENTS m = {0, 0.0, 0.0};
+    float median;
+    int ok = make_runs(in, (int)cap, &runs, &nruns, &m)
+             && nruns > 0
+             && reduce_runs(&runs, &nruns, mem_budget)
+             && runs_median(runs, nruns, m.count, &median);
+
+    if (ok) {
+        fprintf(out, "Record count: %lld\n", m.count);
+        fprintf(out, "Average: %.2f\n", (float)m.mean);
+        fprintf(out, "Stddev: %.2f\n", (float)moments_stddev(&m));
+        fprintf(out, "Median: %.2f\n", median);
+        fprintf(out, "\n");
+        ok = merge_runs(runs, nruns, mem_budget, NULL, out);
+    }
+
+    free_runs(runs, nruns);
+    return ok;
+}
@@ -0,0 +1,24 @@
+/*
+ * External merge sort of record files that do not fit in memory.
+ */
+
+ #ifndef MYEXTSORT_H
+ #define MYEXTSORT_H
+
+ #include <stdio.h>
+
+ #define EXTSORT_DEFAULT_BUDGET ((size_t)1 << 30)
+ #define EXTSORT_MAX_FAN_IN 128
+
+ /*
+  * Write the report of report_data for a record file of any size, using about
+  * mem_budget bytes: sorted runs are spilled to temporary files as raw RECORDs,
+  * merged with a loser tree, and the graded lines streamed to out. Up to
+  * EXTSORT_MAX_FAN_IN runs merge in one pass; more are first merged into
+  * longer runs. The median is selected from the runs before the final merge.
+  * mem_budget 0 selects EXTSORT_DEFAULT_BUDGET. Return 1 if successful, 0 if
+  * the file has no records, memory or temporary files run out, or a write fails.
+  */
+ int report_data_external(FILE *in, FILE *out, size_t mem_budget);
+
+ #endif
@@ -0,0 +1,72 @@
+/*
+--------------------------------------------------
+Project: a4
+File:    myextsort_ptest.c
+About:   public test driver for myextsort
+Version: 2026-10-18
+--------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "myrecord.h"
+#include "myextsort.h"
+
+// copy a stream into a malloc'd buffer; *len receives its size
+char *slurp(FILE *fp, long *len) {
+	fseek(fp, 0, SEEK_END);
+	*len = ftell(fp);
+	rewind(fp);
+	char *buf = malloc(*len + 1);
+	if (buf && fread(buf, 1, *len, fp) != (size_t)*len) {
+		free(buf);
+		buf = NULL;
+	}
+	return buf;
+}
+
+void test_report_data_external(int n, size_t budget) {
+	printf("------------------\n");
+	printf("Test: report_data_external(%d records, %zu byte budget)\n\n", n, budget);
+
+	FILE *in = tmpfile(), *ext = tmpfile(), *mem = tmpfile();
+	if (!in || !ext || !mem) {
+		perror("tmpfile");
+		return;
+	}
+	srand(n);
+	for (int i = 0; i < n; i++)
+		fprintf(in, "S%d,%.2f\n", i, (rand() % 10001) / 100.0);
+
+	rewind(in);
+	int ok = report_data_external(in, ext, budget);
+	printf("report_data_external(): %d\n", ok);
+
+	rewind(in);
+	DATASET *ds = import_dataset(in);
+	if (ds) report_dataset(mem, ds, process_dataset(ds));
+	dataset_free(ds);
+
+	long la, lb;
+	char *a = slurp(ext, &la), *b = slurp(mem, &lb);
+	printf("same as report_data: %s\n", a && b && la == lb && memcmp(a, b, la) == 0 ? "yes" : "no");
+	if (a) {
+		a[la] = '\0';
+		char *end = strstr(a, "\n\n");
+		if (end) printf("%.*s\n", (int)(end - a), a);
+	}
+	free(a);
+	free(b);
+	fclose(in);
+	fclose(ext);
+	fclose(mem);
+	printf("\n");
+}
+
+int main(int argc, char *args[]) {
+	test_report_data_external(1001, 0);
+	test_report_data_external(100000, 1 << 20);
+	test_report_data_external(600000, 1 << 16);
+	return 0;
+}
@@ -0,0 +1,268 @@
+/*
+ * Group-by aggregation of records into per-group STATS.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "myrecord.h"
+#include "mystats.h"
+#include "mygroup.h"
+
+#define GROUP_MIN_CHUNK (1 << 16)
+#define GROUP_MIN_SLOTS 64
+
+// aggregate state of one group; MOMENTS merge exactly across threads
+typedef struct {
+    char key[20];
+    int len;
+    uint32_t hash;
+    MOMENTS m;
+} GROUP_STATE;
+
+/*
+ * Open-addressing hash table with linear probing. Slots hold indexes into
+ * states, which stay in insertion order; the table is kept at most half full.
+ */
+typedef struct {
+    GROUP_STATE *states;
+    int count, capacity;
+    int *slots;             // -1 for empty
+    uint32_t mask;
+} GROUP_TABLE;
+
+typedef struct {
+    const RECORD *records;
+    long long n;
+    int prefix_len;
+    char sep;
+    uint32_t *gid;          // per record, index into table.states
+    GROUP_TABLE table;
+    int ok;
+} GROUP_TASK;
+
+// length of the key of a name
+static int key_length(const char *name, int prefix_len, char sep) {
+    int len = 0;
+    while (len < 19 && name[len] && name[len] != sep) len++;
+    if (prefix_len > 0 && len > prefix_len) len = prefix_len;
+    return len;
+}
+
+// FNV-1a
+static uint32_t key_hash(const char *key, int len) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int table_init(GROUP_TABLE *t) {
+    memset(t, 0, sizeof *t);
+    t->slots = malloc(GROUP_MIN_SLOTS * sizeof *t->slots);
+    if (!t->slots) return 0;
+    memset(t->slots, -1, GROUP_MIN_SLOTS * sizeof *t->slots);
+    t->mask = GROUP_MIN_SLOTS - 1;
+    return 1;
+}
+
+static void table_free(GROUP_TABLE *t) {
+    free(t->states);
+    free(t->slots);
+}
+
+// double the slots and reinsert every state; 0 if out of memory
+static int table_rehash(GROUP_TABLE *t) {
+    uint32_t size = (t->mask + 1) * 2;
+    int *slots = malloc(size * sizeof *slots);
+    if (!slots) return 0;
+    memset(slots, -1, size * sizeof *slots);
+    for (int i = 0; i < t->count; i++) {
+        uint32_t h = t->states[i].hash & (size - 1);
+        while (slots[h] != -1) h = (h + 1) & (size - 1);
+        slots[h] = i;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->mask = size - 1;
+    return 1;
+}
+
+/*
+ * Index of the state for a key, adding an empty one if the key is new.
+ * Return -1 if out of memory.
+ */
+static int table_find(GROUP_TABLE *t, const char *key, int len, uint32_t hash) {
+    uint32_t h = hash & t->mask;
+    for (int s; (s = t->slots[h]) != -1; h = (h + 1) & t->mask) {
+        const GROUP_STATE *g = &t->states[s];
+        if (g->hash == hash && g->len == len && memcmp(g->key, key, len) == 0)
+            return s;
+    }
+
+    if (t->count == t->capacity) {
+        int cap = t->capacity ? t->capacity * 2 : GROUP_MIN_SLOTS / 2;
+        GROUP_STATE *st = realloc(t->states, cap * sizeof *st);
+        if (!st) return -1;
+        t->states = st;
+        t->capacity = cap;
+    }
+    GROUP_STATE *g = &t->states[t->count];
+    memset(g, 0, sizeof *g);
+    memcpy(g->key, key, len);
+    g->len = len;
+    g->hash = hash;
+    t->slots[h] = t->count++;
+
+    if ((uint32_t)t->count * 2 > t->mask + 1 && !table_rehash(t)) return -1;
+    return t->count - 1;
+}
+
+// aggregate one chunk of records into the thread's own table
+static void *group_worker(void *arg) {
+    GROUP_TASK *t = arg;
+    t->ok = table_init(&t->table);
+    for (long long i = 0; t->ok && i < t->n; i++) {
+        const RECORD *r = &t->records[i];
+        int len = key_length(r->name, t->prefix_len, t->sep);
+        int g = table_find(&t->table, r->name, len, key_hash(r->name, len));
+        if (g < 0) {
+            t->ok = 0;
+            break;
+        }
+        moments_add(&t->table.states[g].m, r->score);
+        t->gid[i] = (uint32_t)g;
+    }
+    return NULL;
+}
+
+/**
+ * Group records by a key taken from the name and compute STATS per group.
+ * One pass over the records builds a hash table of mergeable moments per
+ * thread and tags each record with its group; the tables are merged in
+ * chunk order, so groups keep the order they first appear in. Medians need
+ * each group's scores together: one scatter by group tag places them in
+ * contiguous segments, and each segment's median is selected in O(size).
+ *
+ * @param *dataset - pointer to dataset array.
+ * @param n - the number of data record in dataset array.
+ * @param prefix_len - longest key, <= 0 for no limit.
+ * @param sep - the key ends before the first sep in the name; '\0' for none.
+ * @param nthreads - number of threads, <= 0 for one per online CPU.
+ * @return - the groups, or NULL if out of memory.
+ */
+GROUPS *group_by(const RECORD *dataset, int n, int prefix_len, char sep, int nthreads) {
+    if (n < 0 || (n > 0 && !dataset)) return NULL;
+    if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > n / GROUP_MIN_CHUNK) nthreads = n / GROUP_MIN_CHUNK;
+    if (nthreads < 1) nthreads = 1;
+
+    GROUPS *out = calloc(1, sizeof *out);
+    GROUP_TASK *tasks = calloc(nthreads, sizeof *tasks);
+    pthread_t *threads = malloc(nthreads * sizeof *threads);
+    int *started = calloc(nthreads, sizeof *started);
+    uint32_t *gid = malloc(((size_t)n + 1) * sizeof *gid);
+    GROUP_TABLE all;
+    int ok = out && tasks && threads && started && gid && table_init(&all);
+    if (!ok) {
+        free(out);
+        free(tasks);
+        free(threads);
+        free(started);
+        free(gid);
+        return NULL;
+    }
+
+    long long chunk = n / nthreads;
+    for (int i = 0; i < nthreads; i++) {
+        tasks[i].records = dataset + i * chunk;
+        tasks[i].n = (i == nthreads - 1) ? n - i * chunk : chunk;
+        tasks[i].prefix_len = prefix_len;
+        tasks[i].sep = sep;
+        tasks[i].gid = gid + i * chunk;
+    }
+    for (int i = 1; i < nthreads; i++)
+        started[i] = pthread_create(&threads[i], NULL, group_worker, &tasks[i]) == 0;
+    group_worker(&tasks[0]);
+    for (int i = 1; i < nthreads; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            group_worker(&tasks[i]);
+    }
+
+    // merge the thread tables in order and retag the records with global groups
+    for (int i = 0; ok && i < nthreads; i++) {
+        GROUP_TABLE *t = &tasks[i].table;
+        ok = tasks[i].ok;
+        int *remap = ok ? malloc((t->count + 1) * sizeof *remap) : NULL;
+        ok = ok && remap;
+        for (int j = 0; ok && j < t->count; j++) {
+            GROUP_STATE *g = &t->states[j];
+            remap[j] = table_find(&all, g->key, g->len, g->hash);
+            ok = remap[j] >= 0;
+            if (ok) moments_merge(&all.states[remap[j]].m, &g->m);
+        }
+        for (long long k = 0; ok && k < tasks[i].n; k++)
+            tasks[i].gid[k] = remap[tasks[i].gid[k]];
+        free(remap);
+    }
+
+    // scatter scores into one contiguous segment per group, then take medians
+    float *scores = ok ? malloc(((size_t)n + 1) * sizeof *scores) : NULL;
+    long long *pos = ok ? malloc((all.count + 1) * sizeof *pos) : NULL;
+    out->groups = ok ? malloc((all.count + 1) * sizeof *out->groups) : NULL;
+    ok = ok && scores && pos && out->groups;
+    if (ok) {
+        long long at = 0;
+        for (int g = 0; g < all.count; g++) {
+            pos[g] = at;
+            at += all.states[g].m.count;
+        }
+        for (int i = 0; i < n; i++)
+            scores[pos[gid[i]]++] = dataset[i].score;
+
+        for (int g = 0; g < all.count; g++) {
+            GROUP_STATE *s = &all.states[g];
+            GROUP *row = &out->groups[g];
+            long long cnt = s->m.count;
+            memset(row->key, 0, sizeof row->key);
+            memcpy(row->key, s->key, s->len);
+            row->stats.count = (int)cnt;
+            row->stats.mean = (float)s->m.mean;
+            row->stats.stddev = (float)moments_stddev(&s->m);
+            row->stats.median = select_median(scores + pos[g] - cnt, (int)cnt);
+        }
+        out->count = all.count;
+    }
+
+    for (int i = 0; i < nthreads; i++) table_free(&tasks[i].table);
+    table_free(&all);
+    free(tasks);
+    free(threads);
+    free(started);
+    free(gid);
+    free(scores);
+    free(pos);
+    if (!ok) {
+        groups_free(out);
+        return NULL;
+    }
+    return out;
+}
+
+/**
+ * Release the result of group_by.
+ *
+ * @param *g - groups, may be NULL.
+ */
+void groups_free(GROUPS *g) {
+    if (!g) return;
+    free(g->groups);
+    free(g);
+}
@@ -0,0 +1,34 @@
+/*
+ * Group-by aggregation of records into per-group STATS.
+ */
+
+ #ifndef MYGROUP_H
+ #define MYGROUP_H
+
+ #include <stdio.h>
+ #include "myrecord.h"
+
+ // one output row: the group key and the STATS of its records
+ typedef struct {
+   char key[20];
+   STATS stats;
+ } GROUP;
+
+ // groups in order of first appearance in the dataset
+ typedef struct {
+   GROUP *groups;
+   int count;
+ } GROUPS;
+
+ /*
+  * Group records by a key taken from the name: the part before the first sep
+  * character (the whole name if sep is '\0' or absent), cut to at most
+  * prefix_len characters (no limit if prefix_len <= 0). nthreads <= 0 uses
+  * one thread per online CPU. NULL if out of memory.
+  */
+ GROUPS *group_by(const RECORD *dataset, int n, int prefix_len, char sep, int nthreads);
+
+ // release the result of group_by
+ void groups_free(GROUPS *g);
+
+ #endif
@@ -0,0 +1,86 @@
+/*
+--------------------------------------------------
+Project: a4
+File:    mygroup_ptest.c
+About:   public test driver for mygroup
+Version: 2026-10-18
+--------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "myrecord.h"
+#include "mygroup.h"
+
+char *courses[] = {"CS101", "MA200", "PH150", "EN110"};
+
+void print_groups(const GROUPS *g) {
+	printf("%-8s%8s%8s%8s%8s\n", "group", "count", "mean", "stddev", "median");
+	for (int i = 0; i < g->count; i++) {
+		STATS s = g->groups[i].stats;
+		printf("%-8s%8d%8.2f%8.2f%8.2f\n", g->groups[i].key, s.count, s.mean, s.stddev, s.median);
+	}
+}
+
+void test_group_by_marks() {
+	printf("------------------\n");
+	printf("Test: group_by(marks.txt, prefix 1)\n\n");
+	RECORD dataset[100];
+	FILE *fp = fopen("marks.txt", "r");
+	if (fp == NULL) {
+		perror("open input file error");
+		return;
+	}
+	int count = import_data(fp, dataset);
+	fclose(fp);
+
+	GROUPS *g = group_by(dataset, count, 1, '\0', 0);
+	if (g) print_groups(g);
+	groups_free(g);
+	STATS s = process_data(dataset, count);
+	printf("process_data: %d %.2f %.2f %.2f\n\n", s.count, s.mean, s.stddev, s.median);
+}
+
+void test_group_by_course() {
+	printf("------------------\n");
+	printf("Test: group_by(course-name, sep '-')\n\n");
+	int n = 400000, ncourse = sizeof courses / sizeof *courses;
+	RECORD *dataset = malloc(n * sizeof *dataset);
+	RECORD *part = malloc(n * sizeof *part);
+	if (!dataset || !part) return;
+	srand(22);
+	for (int i = 0; i < n; i++) {
+		int c = rand() % ncourse;
+		snprintf(dataset[i].name, sizeof dataset[i].name, "%s-S%d", courses[c], i);
+		dataset[i].score = (rand() % (400 + 100 * c)) / 5.0f;
+	}
+
+	GROUPS *g = group_by(dataset, n, 0, '-', 4);
+	if (!g) return;
+	print_groups(g);
+
+	// each group's STATS against process_data over just its records
+	int match = 1;
+	for (int i = 0; i < g->count; i++) {
+		int m = 0;
+		for (int j = 0; j < n; j++)
+			if (strncmp(dataset[j].name, g->groups[i].key, strlen(g->groups[i].key)) == 0)
+				part[m++] = dataset[j];
+		STATS s = process_data(part, m);
+		STATS t = g->groups[i].stats;
+		match = match && s.count == t.count && s.median == t.median
+				&& (double)s.mean - t.mean < 1e-3 && (double)t.mean - s.mean < 1e-3
+				&& (double)s.stddev - t.stddev < 1e-3 && (double)t.stddev - s.stddev < 1e-3;
+	}
+	printf("matches process_data per group: %s\n\n", match ? "yes" : "no");
+	groups_free(g);
+	free(dataset);
+	free(part);
+}
+
+int main(int argc, char *args[]) {
+	test_group_by_marks();
+	test_group_by_course();
+	return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Score and name indexes over imported records.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "myrecord.h"
+#include "mysort.h"
+#include "myindex.h"
+
+#define INDEX_MIN_SLOTS 64
+#define CACHE_LINE 64
+
+// FNV-1a over a NUL-terminated name
+static uint32_t name_hash(const char *name) {
+    uint32_t h = 2166136261u;
+    for (; *name; name++) {
+        h ^= (unsigned char)*name;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*
+ * Fill the subtree of Eytzinger slot k by an in-order walk over the sorted
+ * keys, starting at sorted position i; return the next unused position.
+ */
+static uint32_t eyt_fill(SCORE_INDEX *ix, const KEYPAIR *p, uint32_t i, uint32_t k) {
+    if (k > (uint32_t)ix->scored) return i;
+    i = eyt_fill(ix, p, i, 2 * k);
+    ix->eyt[k] = p[i].key;
+    ix->eyt_pos[k] = i;
+    return eyt_fill(ix, p, i + 1, 2 * k + 1);
+}
+
+/*
+ * Branch-free descent: go right past every key before x, so the answer is
+ * the last slot where the walk went left. The walk's right turns are the
+ * trailing ones of k; shifting them and one more bit off recovers that slot,
+ * or 0 if the walk never went left. The slots four levels down share one
+ * cache line and are prefetched while the current level is compared.
+ */
+static inline int eyt_search(const SCORE_INDEX *ix, float x, int upper) {
+    const float *eyt = ix->eyt;
+    uint32_t n = (uint32_t)ix->scored, k = 1;
+    while (k <= n) {
+        __builtin_prefetch((const char *)eyt + (size_t)k * CACHE_LINE);
+        k = 2 * k + (upper ? eyt[k] <= x : eyt[k] < x);
+    }
+    k >>= __builtin_ffs(~k);
+    return k ? (int)ix->eyt_pos[k] : ix->scored;
+}
+
+static int build_scores(SCORE_INDEX *ix) {
+    const RECORD *r = ix->records;
+    KEYPAIR *p = malloc(((size_t)ix->count + 1) * sizeof *p);
+    int n = 0;
+    if (!p) return 0;
+    for (int i = 0; i < ix->count; i++) {
+        if (isnan(r[i].score)) continue;
+        p[n].key = r[i].score;
+        p[n++].index = (uint32_t)i;
+    }
+    ix->scored = n;
+
+    // pair_sort is a stable radix sort, so equal scores keep record order
+    void *eyt = NULL;
+    ix->order = malloc(((size_t)n + 1) * sizeof *ix->order);
+    ix->eyt_pos = malloc(((size_t)n + 1) * sizeof *ix->eyt_pos);
+    int ok = ix->order && ix->eyt_pos && posix_memalign(&eyt, CACHE_LINE, ((size_t)n + 1) * sizeof(float)) == 0;
+    ix->eyt = eyt;
+    ok = ok && pair_sort(p, n);
+    if (ok) {
+        for (int i = 0; i < n; i++)
+            ix->order[i] = p[i].index;
+        eyt_fill(ix, p, 0, 1);
+    }
+    free(p);
+    return ok;
+}
+
+static int build_names(SCORE_INDEX *ix) {
+    uint32_t size = INDEX_MIN_SLOTS;
+    while (size < 2 * (uint32_t)ix->count) size *= 2;
+    ix->slots = malloc(size * sizeof *ix->slots);
+    if (!ix->slots) return 0;
+    for (uint32_t s = 0; s < size; s++)
+        ix->slots[s].record = -1;
+    ix->mask = size - 1;
+
+    // a repeated name lands further along its probe sequence, so lookups
+    // meet the first record with it first
+    for (int i = 0; i < ix->count; i++) {
+        uint32_t hash = name_hash(ix->records[i].name);
+        uint32_t h = hash & ix->mask;
+        while (ix->slots[h].record != -1) h = (h + 1) & ix->mask;
+        ix->slots[h].hash = hash;
+        ix->slots[h].record = i;
+    }
+    return 1;
+}
+
+/**
+ * Build the score and name indexes over a dataset, in O(n): a radix sort of
+ * (score, index) pairs, an in-order fill of the Eytzinger array, and one
+ * hash insert per record. The dataset is not copied and must not change
+ * while the index is in use.
+ *
+ * @param *dataset - pointer to dataset array.
+ * @param n - the number of data record in dataset array.
+ * @return - the index, or NULL if out of memory.
+ */
+SCORE_INDEX *index_build(const RECORD *dataset, int n) {
+    if (n < 0 || (n > 0 && !dataset)) return NULL;
+    SCORE_INDEX *ix = calloc(1, sizeof *ix);
+    if (!ix) return NULL;
+    ix->records = dataset;
+    ix->count = n;
+    if (!build_scores(ix) || !build_names(ix)) {
+        index_free(ix);
+        return NULL;
+    }
+    return ix;
+}
+
+/**
+ * Release an index; the dataset is left alone.
+ *
+ * @param *ix - the index, may be NULL.
+ */
+void index_free(SCORE_INDEX *ix) {
+    if (!ix) return;
+    free(ix->order);
+    free(ix->eyt);
+    free(ix->eyt_pos);
+    free(ix->slots);
+    free(ix);
+}
+
+/**
+ * Lower bound of a score, in O(log n).
+ *
+ * @param *ix - the index.
+ * @param x - the score.
+ * @return - position in order of the first score >= x, scored if none.
+ */
+int index_lower(const SCORE_INDEX *ix, float x) {
+    return eyt_search(ix, x, 0);
+}
+
+/**
+ * Upper bound of a score, in O(log n).
+ *
+ * @param *ix - the index.
+ * @param x - the score.
+ * @return - position in order of the first score > x, scored if none.
+ */
+int index_upper(const SCORE_INDEX *ix, float x) {
+    return eyt_search(ix, x, 1);
+}
+
+/**
+ * Records scoring in [lo, hi], found with two searches.
+ *
+ * @param *ix - the index.
+ * @param lo - lowest score.
+ * @param hi - highest score.
+ * @param *first - set to the position in order of the first match.
+ * @return - the number of matches; 0 if lo > hi or either is NaN.
+ */
+int index_range(const SCORE_INDEX *ix, float lo, float hi, int *first) {
+    *first = 0;
+    if (!(lo <= hi)) return 0;
+    *first = index_lower(ix, lo);
+    return index_upper(ix, hi) - *first;
+}
+
+/**
+ * Class rank of a score; equal scores share a rank.
+ *
+ * @param *ix - the index.
+ * @param score - the score.
+ * @return - 1 + the number of records scoring higher, 0 for NaN.
+ */
+int index_rank(const SCORE_INDEX *ix, float score) {
+    if (isnan(score)) return 0;
+    return 1 + ix->scored - index_upper(ix, score);
+}
+
+/**
+ * Look a name up in the hash index, in O(1) expected.
+ *
+ * @param *ix - the index.
+ * @param *name - the name.
+ * @return - the first record with the name, -1 if none.
+ */
+int index_find(const SCORE_INDEX *ix, const char *name) {
+    uint32_t hash = name_hash(name);
+    for (uint32_t h = hash & ix->mask; ix->slots[h].record != -1; h = (h + 1) & ix->mask) {
+        const NAME_SLOT *s = &ix->slots[h];
+        if (s->hash == hash && strcmp(ix->records[s->record].name, name) == 0)
+            return s->record;
+    }
+    return -1;
+}
+
+/**
+ * Class rank of a named record.
+ *
+ * @param *ix - the index.
+ * @param *name - the name.
+ * @return - index_rank of the first record with the name, 0 if none.
+ */
+int index_rank_of(const SCORE_INDEX *ix, const char *name) {
+    int i = index_find(ix, name);
+    return i < 0 ? 0 : index_rank(ix, ix->records[i].score);
+}
@@ -0,0 +1,60 @@
+/*
+ * Score and name indexes over imported records.
+ */
+
+ #ifndef MYINDEX_H
+ #define MYINDEX_H
+
+ #include <stdio.h>
+ #include <stdint.h>
+ #include "myrecord.h"
+
+ // name hash slot: FNV-1a hash of the name and the record, -1 if empty
+ typedef struct {
+   uint32_t hash;
+   int record;
+ } NAME_SLOT;
+
+ /*
+  * Read-only indexes over a dataset that must outlive them. order holds the
+  * indexes of the records with a score, by increasing score and then record
+  * index; NaN scores are left out. The same keys are also laid out in
+  * Eytzinger (BFS) order, 1-based, so a binary search walks down an implicit
+  * tree whose top levels share a few cache lines; eyt_pos maps each slot
+  * back to its position in order. Names go in an open-addressing hash table
+  * kept at most half full.
+  */
+ typedef struct {
+   const RECORD *records;
+   int count;                // records indexed
+   int scored;               // records in order
+   uint32_t *order;
+   float *eyt;               // eyt[1..scored]
+   uint32_t *eyt_pos;
+   NAME_SLOT *slots;
+   uint32_t mask;
+ } SCORE_INDEX;
+
+ // build both indexes over dataset[0..n-1]; NULL if out of memory
+ SCORE_INDEX *index_build(const RECORD *dataset, int n);
+
+ void index_free(SCORE_INDEX *ix);
+
+ // position in order of the first score >= x (index_upper: > x)
+ int index_lower(const SCORE_INDEX *ix, float x);
+ int index_upper(const SCORE_INDEX *ix, float x);
+
+ // number of records with lo <= score <= hi; they are
+ // order[*first .. *first + count - 1], by increasing score
+ int index_range(const SCORE_INDEX *ix, float lo, float hi, int *first);
+
+ // class rank of a score: 1 + the number of records scoring higher; 0 for NaN
+ int index_rank(const SCORE_INDEX *ix, float score);
+
+ // first record with the name, -1 if none
+ int index_find(const SCORE_INDEX *ix, const char *name);
+
+ // index_rank of the first record with the name, 0 if none
+ int index_rank_of(const SCORE_INDEX *ix, const char *name);
+
+ #endif
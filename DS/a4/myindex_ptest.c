@@ -0,0 +1,91 @@
+/*
+--------------------------------------------------
+Project: a4
+File:    myindex_ptest.c
+About:   public test driver for myindex
+Version: 2026-10-18
+--------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "myrecord.h"
+#include "myindex.h"
+
+void test_index_marks() {
+	printf("------------------\n");
+	printf("Test: index_build(marks.txt)\n\n");
+	RECORD dataset[100];
+	FILE *fp = fopen("marks.txt", "r");
+	if (fp == NULL) {
+		perror("open input file error");
+		return;
+	}
+	int count = import_data(fp, dataset);
+	fclose(fp);
+
+	SCORE_INDEX *ix = index_build(dataset, count);
+	if (!ix) return;
+	int first, n = index_range(ix, 35.0f, 70.0f, &first);
+	printf("index_range(35, 70): %d\n", n);
+	for (int i = first; i < first + n; i++)
+		printf("%s,%.1f\n", dataset[ix->order[i]].name, dataset[ix->order[i]].score);
+	printf("index_range(70, 35): %d\n", index_range(ix, 70.0f, 35.0f, &first));
+	printf("index_find(A7): %d\n", index_find(ix, "A7"));
+	printf("index_find(A11): %d\n", index_find(ix, "A11"));
+	printf("index_rank_of(A7): %d\n", index_rank_of(ix, "A7"));
+	printf("index_rank_of(A10): %d\n", index_rank_of(ix, "A10"));
+	printf("index_rank(55.0): %d\n\n", index_rank(ix, 55.0f));
+	index_free(ix);
+}
+
+void test_index_random() {
+	printf("------------------\n");
+	printf("Test: index queries against a linear scan\n\n");
+	int n = 300000, queries = 200;
+	RECORD *dataset = malloc(n * sizeof *dataset);
+	if (!dataset) return;
+	srand(25);
+	for (int i = 0; i < n; i++) {
+		snprintf(dataset[i].name, sizeof dataset[i].name, "S%d", rand() % (n / 2));
+		dataset[i].score = (rand() % 1001) / 10.0f;
+	}
+
+	SCORE_INDEX *ix = index_build(dataset, n);
+	if (!ix) return;
+	int sorted = 1;
+	for (int i = 1; i < ix->scored; i++) {
+		const RECORD *a = &dataset[ix->order[i - 1]], *b = &dataset[ix->order[i]];
+		sorted = sorted && (a->score < b->score || (a->score == b->score && ix->order[i - 1] < ix->order[i]));
+	}
+	printf("order sorted: %s\n", sorted ? "yes" : "no");
+
+	int match = 1;
+	for (int q = 0; q < queries; q++) {
+		float lo = (rand() % 1001) / 10.0f, hi = lo + (rand() % 50) / 10.0f;
+		int first, cnt = index_range(ix, lo, hi, &first), expect = 0, higher = 0;
+		for (int i = 0; i < n; i++) {
+			expect += dataset[i].score >= lo && dataset[i].score <= hi;
+			higher += dataset[i].score > lo;
+		}
+		match = match && cnt == expect && index_rank(ix, lo) == 1 + higher;
+		for (int i = first; i < first + cnt; i++)
+			match = match && dataset[ix->order[i]].score >= lo && dataset[ix->order[i]].score <= hi;
+
+		// the first record with a name, found by scan and by hash
+		const char *name = dataset[rand() % n].name;
+		int at = 0;
+		while (strcmp(dataset[at].name, name) != 0) at++;
+		match = match && index_find(ix, name) == at;
+	}
+	printf("%d range, rank and name queries match a linear scan: %s\n\n", queries, match ? "yes" : "no");
+	index_free(ix);
+	free(dataset);
+}
+
+int main(int argc, char *args[]) {
+	test_index_marks();
+	test_index_random();
+	return 0;
+}
@@ -0,0 +1,287 @@
+/*
+ * Incrementally maintained score statistics.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "myrecord.h"
+#include "mystats.h"
+#include "mylive.h"
+
+#define LIVE_MIN_CAPACITY 64
+#define NIL (-1)
+
+// whether node a orders before node b: by score, then by handle
+static int live_less(const LIVE_NODE *n, int a, int b) {
+    if (n[a].score != n[b].score) return n[a].score < n[b].score;
+    return a < b;
+}
+
+static inline int size_of(const LIVE_NODE *n, int t) {
+    return t == NIL ? 0 : n[t].size;
+}
+
+// recompute the subtree size of t from its children
+static inline void pull(LIVE_NODE *n, int t) {
+    n[t].size = size_of(n, n[t].left) + 1 + size_of(n, n[t].right);
+}
+
+// split t into the nodes before k (*l) and the rest (*r)
+static void split(LIVE_NODE *n, int t, int k, int *l, int *r) {
+    if (t == NIL) {
+        *l = *r = NIL;
+    } else if (live_less(n, t, k)) {
+        split(n, n[t].right, k, &n[t].right, r);
+        pull(n, t);
+        *l = t;
+    } else {
+        split(n, n[t].left, k, l, &n[t].left);
+        pull(n, t);
+        *r = t;
+    }
+}
+
+// join treaps a and b, every node of a ordering before every node of b
+static int join(LIVE_NODE *n, int a, int b) {
+    if (a == NIL) return b;
+    if (b == NIL) return a;
+    if (n[a].prio > n[b].prio) {
+        n[a].right = join(n, n[a].right, b);
+        pull(n, a);
+        return a;
+    }
+    n[b].left = join(n, a, n[b].left);
+    pull(n, b);
+    return b;
+}
+
+static int insert_node(LIVE_NODE *n, int t, int k) {
+    if (t == NIL) return k;
+    if (n[k].prio > n[t].prio) {
+        split(n, t, k, &n[k].left, &n[k].right);
+        pull(n, k);
+        return k;
+    }
+    if (live_less(n, k, t))
+        n[t].left = insert_node(n, n[t].left, k);
+    else
+        n[t].right = insert_node(n, n[t].right, k);
+    pull(n, t);
+    return t;
+}
+
+static int delete_node(LIVE_NODE *n, int t, int k) {
+    if (t == k) return join(n, n[t].left, n[t].right);
+    if (live_less(n, k, t))
+        n[t].left = delete_node(n, n[t].left, k);
+    else
+        n[t].right = delete_node(n, n[t].right, k);
+    pull(n, t);
+    return t;
+}
+
+// refresh the cached STATS from the running moments and the middle ranks
+static void refresh(LIVESTATS *ls) {
+    STATS s = {0};
+    if (ls->root != NIL) {
+        long long count = ls->moments.count;
+        s.count = (int)count;
+        s.mean = (float)ls->moments.mean;
+        s.stddev = (float)moments_stddev(&ls->moments);
+        s.median = live_rank(ls, count / 2);
+        if (count % 2 == 0)
+            s.median = (live_rank(ls, count / 2 - 1) + s.median) / 2.0f;
+    }
+    ls->stats = s;
+}
+
+// xorshift32 priorities; never 0, which marks free nodes
+static uint32_t next_prio(LIVESTATS *ls) {
+    uint32_t x = ls->seed;
+    do {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    } while (x == 0);
+    ls->seed = x;
+    return x;
+}
+
+/**
+ * Create an empty incremental stats object.
+ *
+ * @return - the object, or NULL if out of memory.
+ */
+LIVESTATS *live_create(void) {
+    LIVESTATS *ls = calloc(1, sizeof *ls);
+    if (!ls) return NULL;
+    ls->root = ls->free_list = NIL;
+    ls->seed = 2463534242u;
+    return ls;
+}
+
+/**
+ * Create an object holding the scores of a dataset; record i gets handle i.
+ *
+ * @param *dataset - pointer to dataset array.
+ * @param n - the number of data record in dataset array.
+ * @return - the object, or NULL if out of memory or a score is NaN.
+ */
+LIVESTATS *live_from_records(const RECORD *dataset, int n) {
+    LIVESTATS *ls = live_create();
+    for (int i = 0; ls && i < n; i++) {
+        if (live_insert(ls, dataset[i].score) != i) {
+            live_free(ls);
+            ls = NULL;
+        }
+    }
+    return ls;
+}
+
+/**
+ * Release an incremental stats object.
+ *
+ * @param *ls - the object, may be NULL.
+ */
+void live_free(LIVESTATS *ls) {
+    if (!ls) return;
+    free(ls->nodes);
+    free(ls);
+}
+
+/**
+ * Add a score in O(log n) expected time.
+ *
+ * @param *ls - the object.
+ * @param score - the score.
+ * @return - the new score's handle, or -1 if out of memory or score is NaN.
+ */
+int live_insert(LIVESTATS *ls, float score) {
+    if (isnan(score)) return -1;
+
+    int k;
+    if (ls->free_list != NIL) {
+        k = ls->free_list;
+        ls->free_list = ls->nodes[k].left;
+    } else {
+        if (ls->used == ls->cap) {
+            int cap = ls->cap ? ls->cap * 2 : LIVE_MIN_CAPACITY;
+            LIVE_NODE *nodes = realloc(ls->nodes, (size_t)cap * sizeof *nodes);
+            if (!nodes) return -1;
+            ls->nodes = nodes;
+            ls->cap = cap;
+        }
+        k = ls->used++;
+    }
+
+    LIVE_NODE *node = &ls->nodes[k];
+    node->score = score;
+    node->prio = next_prio(ls);
+    node->left = node->right = NIL;
+    pull(ls->nodes, k);
+    ls->root = insert_node(ls->nodes, ls->root, k);
+    moments_add(&ls->moments, score);
+    refresh(ls);
+    return k;
+}
+
+static int is_live(const LIVESTATS *ls, int handle) {
+    return handle >= 0 && handle < ls->used && ls->nodes[handle].prio != 0;
+}
+
+/**
+ * Remove a score in O(log n) expected time; its handle may be reused.
+ *
+ * @param *ls - the object.
+ * @param handle - handle from live_insert.
+ * @return - 1 if removed; 0 if the handle is not live.
+ */
+int live_delete(LIVESTATS *ls, int handle) {
+    if (!is_live(ls, handle)) return 0;
+    ls->root = delete_node(ls->nodes, ls->root, handle);
+    moments_remove(&ls->moments, ls->nodes[handle].score);
+    ls->nodes[handle].prio = 0;
+    ls->nodes[handle].left = ls->free_list;
+    ls->free_list = handle;
+    refresh(ls);
+    return 1;
+}
+
+/**
+ * Change a score in O(log n) expected time, keeping its handle.
+ *
+ * @param *ls - the object.
+ * @param handle - handle from live_insert.
+ * @param score - the new score.
+ * @return - 1 if changed; 0 if the handle is not live or score is NaN.
+ */
+int live_update(LIVESTATS *ls, int handle, float score) {
+    if (!is_live(ls, handle) || isnan(score)) return 0;
+    LIVE_NODE *n = ls->nodes;
+    ls->root = delete_node(n, ls->root, handle);
+    moments_remove(&ls->moments, n[handle].score);
+    moments_add(&ls->moments, score);
+    n[handle].score = score;
+    n[handle].left = n[handle].right = NIL;
+    pull(n, handle);
+    ls->root = insert_node(n, ls->root, handle);
+    refresh(ls);
+    return 1;
+}
+
+/**
+ * The current STATS, kept up to date by every change.
+ *
+ * @param *ls - the object.
+ * @return - count, mean, stddev and median; all zero when empty.
+ */
+STATS live_stats(const LIVESTATS *ls) {
+    return ls->stats;
+}
+
+/**
+ * The k-th smallest score, found by walking down by subtree counts.
+ *
+ * @param *ls - the object.
+ * @param k - rank, 0 <= k < count.
+ * @return - the score, or NAN if k is out of range.
+ */
+float live_rank(const LIVESTATS *ls, long long k) {
+    const LIVE_NODE *n = ls->nodes;
+    int t = ls->root;
+    if (t == NIL || k < 0 || k >= n[t].size) return NAN;
+    for (;;) {
+        int left = size_of(n, n[t].left);
+        if (k < left) {
+            t = n[t].left;
+        } else if (k == left) {
+            return n[t].score;
+        } else {
+            k -= left + 1;
+            t = n[t].right;
+        }
+    }
+}
+
+/**
+ * Number of scores less than x.
+ *
+ * @param *ls - the object.
+ * @param x - the score to rank.
+ * @return - the count.
+ */
+long long live_count_below(const LIVESTATS *ls, float x) {
+    const LIVE_NODE *n = ls->nodes;
+    long long below = 0;
+    for (int t = ls->root; t != NIL;) {
+        if (n[t].score < x) {
+            below += 1 + size_of(n, n[t].left);
+            t = n[t].right;
+        } else {
+            t = n[t].left;
+        }
+    }
+    return below;
+}
@@ -0,0 +1,65 @@
+/*
+ * Incrementally maintained score statistics.
+ */
+
+ #ifndef MYLIVE_H
+ #define MYLIVE_H
+
+ #include <stdio.h>
+ #include <stdint.h>
+ #include "myrecord.h"
+ #include "mystats.h"
+
+ // tree node of one score; size counts the nodes of its subtree
+ typedef struct {
+   float score;
+   uint32_t prio;            // 0 marks a free node
+   int left, right;
+   int size;
+ } LIVE_NODE;
+
+ /*
+  * Scores kept in an order-statistic treap keyed on (score, handle), each
+  * node carrying its subtree size, next to running moments that every change
+  * adds to or takes back from. Insert, update and delete are O(log n)
+  * expected and refresh the cached STATS, so live_stats is O(1); any rank is
+  * O(log n). Handles index nodes and are reused after
+  * delete; a fresh object hands out 0, 1, 2, ... so record i of a dataset
+  * inserted in order has handle i.
+  */
+ typedef struct {
+   LIVE_NODE *nodes;
+   int cap, used;
+   int root, free_list;
+   uint32_t seed;
+   MOMENTS moments;
+   STATS stats;
+ } LIVESTATS;
+
+ // empty object; NULL if out of memory
+ LIVESTATS *live_create(void);
+
+ // object holding the scores of dataset[0..n-1] with handles 0..n-1
+ LIVESTATS *live_from_records(const RECORD *dataset, int n);
+
+ void live_free(LIVESTATS *ls);
+
+ // add a score; its handle, or -1 if out of memory or score is NaN
+ int live_insert(LIVESTATS *ls, float score);
+
+ // change the score of a handle; 0 if the handle is not live or score is NaN
+ int live_update(LIVESTATS *ls, int handle, float score);
+
+ // remove a handle; 0 if it is not live
+ int live_delete(LIVESTATS *ls, int handle);
+
+ // current STATS, as process_data would compute them
+ STATS live_stats(const LIVESTATS *ls);
+
+ // k-th smallest score, 0 <= k < count
+ float live_rank(const LIVESTATS *ls, long long k);
+
+ // number of scores less than x
+ long long live_count_below(const LIVESTATS *ls, float x);
+
+ #endif
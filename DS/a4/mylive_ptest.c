@@ -0,0 +1,104 @@
+/*
+--------------------------------------------------
+Project: a4
+File:    mylive_ptest.c
+About:   public test driver for mylive
+Version: 2026-10-18
+--------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "myrecord.h"
+#include "mylive.h"
+
+void print_stats(const char *label, STATS s) {
+	printf("%-14s%8d%8.2f%8.2f%8.2f\n", label, s.count, s.mean, s.stddev, s.median);
+}
+
+int same_stats(STATS s, STATS t) {
+	return s.count == t.count && s.median == t.median
+			&& (double)s.mean - t.mean < 1e-3 && (double)t.mean - s.mean < 1e-3
+			&& (double)s.stddev - t.stddev < 1e-3 && (double)t.stddev - s.stddev < 1e-3;
+}
+
+void test_live_marks() {
+	printf("------------------\n");
+	printf("Test: live_from_records(marks.txt), update, delete\n\n");
+	RECORD dataset[100];
+	FILE *fp = fopen("marks.txt", "r");
+	if (fp == NULL) {
+		perror("open input file error");
+		return;
+	}
+	int count = import_data(fp, dataset);
+	fclose(fp);
+
+	LIVESTATS *ls = live_from_records(dataset, count);
+	if (!ls) return;
+	printf("%-14s%8s%8s%8s%8s\n", "", "count", "mean", "stddev", "median");
+	print_stats("live", live_stats(ls));
+	print_stats("process_data", process_data(dataset, count));
+
+	// record 0 gets a new score, then the last record is dropped
+	live_update(ls, 0, 100.0f);
+	dataset[0].score = 100.0f;
+	live_delete(ls, count - 1);
+	count--;
+	print_stats("live", live_stats(ls));
+	print_stats("process_data", process_data(dataset, count));
+
+	printf("min %.1f, max %.1f, below 60: %lld\n", live_rank(ls, 0),
+			live_rank(ls, count - 1), live_count_below(ls, 60.0f));
+	printf("delete again: %d\n\n", live_delete(ls, count));
+	live_free(ls);
+}
+
+void test_live_random() {
+	printf("------------------\n");
+	printf("Test: random insert/update/delete against process_data\n\n");
+	int cap = 2000, ops = 20000;
+	RECORD *dataset = malloc(cap * sizeof *dataset);
+	int *handle = malloc(cap * sizeof *handle);
+	LIVESTATS *ls = live_create();
+	if (!dataset || !handle || !ls) return;
+
+	// dataset[0..n-1] mirrors the live scores, handle[i] is record i's handle
+	int n = 0, match = 1;
+	srand(24);
+	for (int op = 0; op < ops && match; op++) {
+		int r = rand() % 4, i = n ? rand() % n : 0;
+		float score = (rand() % 1001) / 10.0f;
+		if (n == 0 || (r < 2 && n < cap)) {
+			dataset[n].score = score;
+			handle[n++] = live_insert(ls, score);
+		} else if (r == 2) {
+			dataset[i].score = score;
+			live_update(ls, handle[i], score);
+		} else {
+			live_delete(ls, handle[i]);
+			dataset[i] = dataset[--n];
+			handle[i] = handle[n];
+		}
+		if (op % 97 == 0 && n > 0) {
+			float k = live_rank(ls, n / 3);
+			long long below = live_count_below(ls, k);
+			match = match && below <= n / 3 && live_count_below(ls, k + 0.05f) > n / 3;
+		}
+		match = match && same_stats(live_stats(ls), process_data(dataset, n));
+	}
+	printf("live STATS after %d operations match process_data: %s\n", ops, match ? "yes" : "no");
+	print_stats("live", live_stats(ls));
+	print_stats("process_data", process_data(dataset, n));
+	printf("\n");
+	live_free(ls);
+	free(dataset);
+	free(handle);
+}
+
+int main(int argc, char *args[]) {
+	test_live_marks();
+	test_live_random();
+	return 0;
+}
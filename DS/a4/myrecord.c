@@ -1,9 +1,20 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "myrecord.h"
 #include "mysort.h"
+#include "mystats.h"
 /*
  * Define a structure named RECORD to hold a person's name of 20 characters and 
  * the score of float type.
@@ -19,46 +30,111 @@
 */
 
 /*
- * Convert a percentage grade to letter grade defined by percentage ranges
- * A+=[90, 100], A=[85, 90), A-=[80, 85), B+=[77, 80), B=[73, 77) B=[70, 73),
- * C+=[67, 70), C=[63, 77), C-=[60, 63), D+=[57,60),D=[53,57),D=[50,53), F=[0,50).
- * Use binary search algorithm to find the corresponding letter grade.  
+ * The default scale: percentage ranges A+=[90, 100], A=[85, 90), A-=[80, 85),
+ * B+=[77, 80), B=[73, 77), B-=[70, 73), C+=[67, 70), C=[63, 67), C-=[60, 63),
+ * D+=[57, 60), D=[53, 57), D-=[50, 53), F=[0, 50).
+ */
+const GRADE_SCALE grade_scale_default = {
+    12,
+    {50, 53, 57, 60, 63, 67, 70, 73, 77, 80, 85, 90},
+    {{"F"}, {"D-"}, {"D"}, {"D+"}, {"C-"}, {"C"}, {"C+"},
+     {"B-"}, {"B"}, {"B+"}, {"A-"}, {"A"}, {"A+"}}
+};
+
+/*
+ * Number of cutoffs of a caller-supplied scale that are actually used: count
+ * clamped to [0, GRADE_MAX_CUTOFFS], so ids always index letters[].
+ */
+static int scale_cutoffs(const GRADE_SCALE *scale) {
+    if (scale->count < 0) return 0;
+    return scale->count > GRADE_MAX_CUTOFFS ? GRADE_MAX_CUTOFFS : scale->count;
+}
+
+/*
+ * Grade id of a score on a scale: the number of cutoffs it reaches, counted
+ * without branches. NaN reaches none and grades lowest.
+ */
+static uint8_t grade_id(const GRADE_SCALE *scale, float score) {
+    int id = 0, count = scale_cutoffs(scale);
+    for (int i = 0; i < count; i++)
+        id += score >= scale->cutoff[i];
+    return (uint8_t)id;
+}
+
+/*
+ * Convert a percentage grade to letter grade on the default scale. The
+ * letter comes from the scale's table; nothing is copied per call beyond
+ * the returned struct.
  * 
  * @param score -  percetage grade.
  *
  * @return - letter grade wrapped in GRADE structure type.
  */
 GRADE grade(float score) {
-    GRADE r = {"F"};
-
-    if (score >= 90)
-        strcpy(r.letter_grade, "A+");
-    else if (score >= 85)
-        strcpy(r.letter_grade, "A");
-    else if (score >= 80)
-        strcpy(r.letter_grade, "A-");
-    else if (score >= 77)
-        strcpy(r.letter_grade, "B+");
-    else if (score >= 73)
-        strcpy(r.letter_grade, "B");
-    else if (score >= 70)
-        strcpy(r.letter_grade, "B-");
-    else if (score >= 67)
-        strcpy(r.letter_grade, "C+");
-    else if (score >= 63)
-        strcpy(r.letter_grade, "C");
-    else if (score >= 60)
-        strcpy(r.letter_grade, "C-");
-    else if (score >= 57)
-        strcpy(r.letter_grade, "D+");
-    else if (score >= 53)
-        strcpy(r.letter_grade, "D");
-    else if (score >= 50)
-        strcpy(r.letter_grade, "D-");
-    else
-        strcpy(r.letter_grade, "F");
-
-    return r;
+    return grade_scale_default.letters[grade_id(&grade_scale_default, score)];
+}
+
+/*
+ * Grade n scores on a scale, writing ids that index scale->letters. With SSE2
+ * each group of 16 scores is compared against every cutoff at once and the
+ * true lanes are counted, so the cost is one compare per cutoff per 4 scores
+ * and no branches on the data.
+ *
+ * @param *scale - the grading scale; NULL for the default.
+ * @param *scores - n scores.
+ * @param n - number of scores.
+ * @param *grade_ids - output array of n ids.
+ */
+void grade_many_scale(const GRADE_SCALE *scale, const float *scores, int n, uint8_t *grade_ids) {
+    if (!scale) scale = &grade_scale_default;
+    int i = 0;
+#ifdef __SSE2__
+    int count = scale_cutoffs(scale);
+    for (; i + 16 <= n; i += 16) {
+        __m128i c0 = _mm_setzero_si128(), c1 = c0, c2 = c0, c3 = c0;
+        __m128 s0 = _mm_loadu_ps(scores + i), s1 = _mm_loadu_ps(scores + i + 4);
+        __m128 s2 = _mm_loadu_ps(scores + i + 8), s3 = _mm_loadu_ps(scores + i + 12);
+        for (int k = 0; k < count; k++) {
+            __m128 t = _mm_set1_ps(scale->cutoff[k]);
+            // each true lane is -1, so subtracting the mask counts it
+            c0 = _mm_sub_epi32(c0, _mm_castps_si128(_mm_cmpge_ps(s0, t)));
+            c1 = _mm_sub_epi32(c1, _mm_castps_si128(_mm_cmpge_ps(s1, t)));
+            c2 = _mm_sub_epi32(c2, _mm_castps_si128(_mm_cmpge_ps(s2, t)));
+            c3 = _mm_sub_epi32(c3, _mm_castps_si128(_mm_cmpge_ps(s3, t)));
+        }
+        __m128i lo = _mm_packs_epi32(c0, c1), hi = _mm_packs_epi32(c2, c3);
+        _mm_storeu_si128((__m128i *)(grade_ids + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < n; i++)
+        grade_ids[i] = grade_id(scale, scores[i]);
+}
+
+/*
+ * Grade n scores on the default scale.
+ *
+ * @param *scores - n scores.
+ * @param n - number of scores.
+ * @param *grade_ids - output array of n ids; grade_scale_default.letters[id]
+ *                     is the letter grade.
+ */
+void grade_many(const float *scores, int n, uint8_t *grade_ids) {
+    grade_many_scale(&grade_scale_default, scores, n, grade_ids);
+}
+
+/*
+ *  Parse one "name, score" line into r; names longer than the RECORD field
+ *  are truncated. Return 1 on success, 0 if the line is not a record.
+ */
+static int parse_record(const char *line, RECORD *r) {
+    char namebuf[64];
+    float score;
+
+    if (sscanf(line, " %63[^,] , %f", namebuf, &score) != 2) return 0;
+    strncpy(r->name, namebuf, sizeof(r->name) - 1);
+    r->name[sizeof(r->name) - 1] = '\0';
+    r->score = score;
+    return 1;
 }
 
 /*
@@ -76,91 +152,869 @@ int import_data(FILE *fp, RECORD *dataset) {
     int i = 0;
 
     while (fgets(line, sizeof(line), fp)) {
-        char namebuf[64];      
-        float score;
+        if (parse_record(line, &dataset[i])) i++;
+    }
+
+    return i; 
+}
 
-        
-        if (sscanf(line, " %63[^,] , %f", namebuf, &score) == 2) {
-            strncpy(dataset[i].name, namebuf, sizeof(dataset[i].name) - 1);
-            dataset[i].name[sizeof(dataset[i].name) - 1] = '\0';
+// fgets(line, 256, fp) hands import_data at most 255 bytes at a time
+#define LINE_CHUNK 255
 
-            dataset[i].score = score;
-            i++;
+/*
+ *  First occurrence of byte ch in [p, end), or end; 16 bytes per step with SSE2.
+ */
+static const char *scan_byte(const char *p, const char *end, char ch) {
+#ifdef __SSE2__
+    __m128i needle = _mm_set1_epi8(ch);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != ch) p++;
+    return p;
+}
+
+static int is_space(char ch) {
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+/*
+ *  Parse a decimal float from [p, end) into *out without locale or sscanf.
+ *  Mantissas up to 2^24 with at most 10 as decimal exponent are exact in
+ *  float, so one float multiply or divide rounds correctly (Clinger's fast
+ *  path); anything else goes to sscanf on a terminated copy, which also
+ *  keeps its exact behavior on malformed forms like "1e" or "infx".
+ *  Return 1 on success, 0 if no number starts at p.
+ */
+static int parse_float(const char *p, const char *end, float *out) {
+    static const float pow10f[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f,
+                                   1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+    const char *s = p;
+    int neg = 0;
+    if (s < end && (*s == '-' || *s == '+')) neg = *s++ == '-';
+
+    // up to 19 digits fit in m; longer mantissas take the slow path
+    uint64_t m = 0;
+    const char *d = s;
+    for (; s < end && (unsigned)(*s - '0') < 10; s++)
+        m = m * 10 + (*s - '0');
+    int digits = s - d, exp10 = 0;
+    if (s < end && *s == '.') {
+        d = ++s;
+        for (; s < end && (unsigned)(*s - '0') < 10; s++)
+            m = m * 10 + (*s - '0');
+        exp10 = -(int)(s - d);
+        digits += s - d;
+    }
+    int fast = digits > 0 && digits <= 19;
+    if (fast && s < end && (*s == 'e' || *s == 'E')) {
+        const char *e = s + 1;
+        int eneg = 0, ev = 0;
+        if (e < end && (*e == '-' || *e == '+')) eneg = *e++ == '-';
+        if (e < end && *e >= '0' && *e <= '9') {
+            for (; e < end && *e >= '0' && *e <= '9'; e++)
+                if (ev < 10000) ev = ev * 10 + (*e - '0');
+            exp10 += eneg ? -ev : ev;
+            s = e;
+        } else {
+            fast = 0;
         }
     }
+    if (fast && s < end && (*s == 'x' || *s == 'X')) fast = 0;
 
-    return i; 
+    if (fast && m <= (1u << 24) && exp10 >= -10 && exp10 <= 10) {
+        float v = (float)m;
+        v = exp10 < 0 ? v / pow10f[-exp10] : v * pow10f[exp10];
+        *out = neg ? -v : v;
+        return 1;
+    }
+
+    // rare forms: long mantissas, large exponents, inf, nan, hex
+    char buf[LINE_CHUNK + 1];
+    size_t len = end - p < LINE_CHUNK ? (size_t)(end - p) : LINE_CHUNK;
+    memcpy(buf, p, len);
+    buf[len] = '\0';
+    return sscanf(buf, "%f", out) == 1;
+}
+
+/*
+ *  Parse one fgets-sized chunk [p, end) with the same rules as
+ *  sscanf(" %63[^,] , %f"). Return 1 and set the untruncated name span and
+ *  the score on success.
+ */
+static int parse_fields(const char *p, const char *end, const char **name_out,
+                        size_t *len_out, float *score) {
+    while (p < end && is_space(*p)) p++;
+    const char *name = p;
+    const char *limit = end - p > 63 ? p + 63 : end;
+    p = scan_byte(p, limit, ',');
+    size_t len = p - name;
+    if (len == 0) return 0;
+
+    while (p < end && is_space(*p)) p++;
+    if (p == end || *p != ',') return 0;
+    for (p++; p < end && is_space(*p); p++)
+        ;
+    if (!parse_float(p, end, score)) return 0;
+
+    *name_out = name;
+    *len_out = len;
+    return 1;
+}
+
+// parse_fields into a RECORD, truncating the name like import_data
+static int parse_chunk(const char *p, const char *end, RECORD *r) {
+    const char *name;
+    size_t len;
+    if (!parse_fields(p, end, &name, &len, &r->score)) return 0;
+
+    memset(r->name, 0, sizeof r->name);
+    memcpy(r->name, name, len < sizeof r->name - 1 ? len : sizeof r->name - 1);
+    return 1;
+}
+
+/*
+ *  Read up to max records from the stream's current position, so files of
+ *  any size can be processed a bounded batch at a time. Lines are parsed as
+ *  import_data parses them.
+ *
+ *  @param *fp -  FILE pointer to intput file.
+ *  @param dataset - array of at least max RECORDs.
+ *  @param max - most records to read.
+ *  @return   - number of records read; 0 at end of file
+ */
+int read_records(FILE *fp, RECORD *dataset, int max) {
+    if (!fp || !dataset) return 0;
+
+    char line[256];
+    int i = 0;
+    while (i < max && fgets(line, sizeof(line), fp)) {
+        if (parse_chunk(line, line + strlen(line), &dataset[i])) i++;
+    }
+    return i;
+}
+
+/*
+ *  End of the chunk fgets(line, 256, fp) would return from p: through the
+ *  next newline, or LINE_CHUNK bytes, or end.
+ */
+static const char *chunk_end(const char *p, const char *end) {
+    const char *limit = end - p > LINE_CHUNK ? p + LINE_CHUNK : end;
+    const char *eol = scan_byte(p, limit, '\n');
+    return eol < limit ? eol + 1 : limit;
+}
+
+typedef struct {
+    void *base;
+    size_t len;
+    const char *p, *end;   // unread part of the file
+} MAPPED;
+
+/*
+ *  Map a regular file from the stream's current position to its end.
+ *  Return 0 if the stream cannot be mapped (pipes, terminals).
+ */
+static int map_stream(FILE *fp, MAPPED *m) {
+    struct stat st;
+    int fd = fileno(fp);
+    long pos = ftell(fp);
+    if (fd < 0 || pos < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        return 0;
+
+    m->base = NULL;
+    m->len = 0;
+    m->p = m->end = NULL;
+    if (st.st_size <= pos) return 1;
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return 0;
+#ifdef POSIX_MADV_SEQUENTIAL
+    posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+    m->base = map;
+    m->len = st.st_size;
+    m->p = (const char *)map + pos;
+    m->end = (const char *)map + st.st_size;
+    return 1;
+}
+
+// release a mapping and leave the stream at end of file, as a read loop would
+static void unmap_stream(FILE *fp, MAPPED *m) {
+    if (m->base) munmap(m->base, m->len);
+    fseek(fp, 0, SEEK_END);
+}
+
+/*
+ *  Import record data like import_data, but map the file into memory and
+ *  parse it in place: SSE2 scans for line and field delimiters and scores go
+ *  through a hand-written float parser, writing straight into the dataset.
+ *  Reading starts at the stream's current position and leaves it at end of
+ *  file. Streams that cannot be mapped (pipes, terminals) fall back to
+ *  import_data.
+ *
+ *  @param *fp -  FILE pointer to intput file.
+ *  @param dataset - array of RECORD type to store record data.
+ *  @return   - number of records
+ */
+int import_data_mmap(FILE *fp, RECORD *dataset) {
+    if (!fp || !dataset) return 0;
+
+    MAPPED m;
+    if (!map_stream(fp, &m)) return import_data(fp, dataset);
+
+    int i = 0;
+    for (const char *p = m.p, *stop; p < m.end; p = stop) {
+        stop = chunk_end(p, m.end);
+        if (parse_chunk(p, stop, &dataset[i])) i++;
+    }
+
+    unmap_stream(fp, &m);
+    return i;
+}
+
+#define DATASET_MIN_CAPACITY 1024
+
+/*
+ *  Make room for at least one more record, doubling the capacity.
+ *  Return 0 if out of memory; the dataset is unchanged then.
+ */
+static int dataset_grow(DATASET *ds) {
+    if (ds->count < ds->capacity) return 1;
+    if (ds->capacity > INT_MAX / 2) return 0;
+
+    int cap = ds->capacity ? ds->capacity * 2 : DATASET_MIN_CAPACITY;
+    RECORD *r = realloc(ds->records, (size_t)cap * sizeof *r);
+    if (!r) return 0;
+    ds->records = r;
+    ds->capacity = cap;
+    return 1;
+}
+
+// append the records of the lines starting in [p, end) to ds; 0 if out of memory
+static int parse_range(const char *p, const char *end, DATASET *ds) {
+    for (const char *stop; p < end; p = stop) {
+        stop = chunk_end(p, end);
+        if (!dataset_grow(ds)) return 0;
+        if (parse_chunk(p, stop, &ds->records[ds->count])) ds->count++;
+    }
+    return 1;
+}
+
+/*
+ *  Import every record of a file into a new dataset that grows as needed,
+ *  so no record count has to be known up front. Regular files are parsed in
+ *  place through a memory map, other streams line by line; the records are
+ *  the same as import_data gives.
+ *
+ *  @param *fp -  FILE pointer to intput file.
+ *  @return   - the dataset, or NULL if fp is NULL or memory runs out
+ */
+DATASET *import_dataset(FILE *fp) {
+    if (!fp) return NULL;
+    DATASET *ds = calloc(1, sizeof *ds);
+    if (!ds) return NULL;
+
+    MAPPED m;
+    int ok = 1;
+    if (map_stream(fp, &m)) {
+        ok = parse_range(m.p, m.end, ds);
+        unmap_stream(fp, &m);
+    } else {
+        char line[256];
+        while (ok && fgets(line, sizeof(line), fp)) {
+            ok = dataset_grow(ds);
+            if (ok && parse_record(line, &ds->records[ds->count])) ds->count++;
+        }
+    }
+
+    if (!ok) {
+        dataset_free(ds);
+        return NULL;
+    }
+    return ds;
+}
+
+#define IMPORT_MIN_RANGE (1 << 20)
+
+typedef struct {
+    const char *p, *end;    // lines starting in [p, end)
+    RECORD *slots;          // room for nslots records in the shared array
+    long long nslots;
+    int count;              // records parsed into slots
+    DATASET overflow;       // records beyond nslots, normally none
+    int ok;
+} IMPORT_TASK;
+
+// newlines in [p, end), 16 bytes per step with SSE2
+static long long count_newlines(const char *p, const char *end) {
+    long long n = 0;
+#ifdef __SSE2__
+    __m128i nl = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)));
+    }
+#endif
+    for (; p < end; p++) n += *p == '\n';
+    return n;
+}
+
+// first pass: a record per line at most, plus one for an unterminated last line
+static void *count_worker(void *arg) {
+    IMPORT_TASK *t = arg;
+    t->nslots = count_newlines(t->p, t->end) + 1;
+    return NULL;
+}
+
+// second pass: parse the range into its slots, spilling any excess
+static void *import_worker(void *arg) {
+    IMPORT_TASK *t = arg;
+    const char *p = t->p;
+    for (const char *stop; p < t->end && t->count < t->nslots; p = stop) {
+        stop = chunk_end(p, t->end);
+        if (parse_chunk(p, stop, &t->slots[t->count])) t->count++;
+    }
+    // only lines cut into several fgets chunks can get here
+    t->ok = parse_range(p, t->end, &t->overflow);
+    return NULL;
+}
+
+/*
+ *  Run worker on every task, the calling thread taking the first; tasks whose
+ *  thread cannot be started run on the calling thread.
+ */
+static void run_tasks(void *(*worker)(void *), IMPORT_TASK *tasks, int n, pthread_t *threads, int *started) {
+    for (int i = 1; i < n; i++)
+        started[i] = pthread_create(&threads[i], NULL, worker, &tasks[i]) == 0;
+    worker(&tasks[0]);
+    for (int i = 1; i < n; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            worker(&tasks[i]);
+    }
+}
+
+/*
+ *  import_dataset with several threads. The mapped file is split into one
+ *  byte range per thread, each moved forward to the start of a line, so
+ *  every line belongs to exactly one range. A first parallel pass counts the
+ *  lines of each range with SSE2, which sizes one shared array and gives each
+ *  range its own slice; the second pass parses the ranges into their slices
+ *  concurrently. Slices are then closed up in range order, which moves
+ *  nothing when every line is a record, so the records and their order are
+ *  the same as import_dataset gives.
+ *
+ *  @param *fp -  FILE pointer to intput file.
+ *  @param nthreads - number of threads, <= 0 for one per online CPU; ranges
+ *                    are at least 1 MB.
+ *  @return   - the dataset, or NULL if fp is NULL or memory runs out
+ */
+DATASET *import_dataset_parallel(FILE *fp, int nthreads) {
+    if (!fp) return NULL;
+    MAPPED m;
+    if (!map_stream(fp, &m)) return import_dataset(fp);
+
+    long long size = m.end - m.p;
+    if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > size / IMPORT_MIN_RANGE) nthreads = (int)(size / IMPORT_MIN_RANGE);
+    if (nthreads < 1) nthreads = 1;
+
+    DATASET *ds = calloc(1, sizeof *ds);
+    IMPORT_TASK *tasks = calloc(nthreads, sizeof *tasks);
+    pthread_t *threads = malloc(nthreads * sizeof *threads);
+    int *started = calloc(nthreads, sizeof *started);
+    int ok = ds && tasks && threads && started;
+
+    long long slots = 0;
+    if (ok) {
+        // range i starts at the first line start at or after i * size / nthreads
+        for (int i = 0; i < nthreads; i++) {
+            const char *s = m.p + size * i / nthreads;
+            if (i > 0) {
+                const char *eol = scan_byte(s - 1, m.end, '\n');
+                s = eol < m.end ? eol + 1 : m.end;
+                tasks[i - 1].end = s;
+            }
+            tasks[i].p = s;
+        }
+        tasks[nthreads - 1].end = m.end;
+
+        run_tasks(count_worker, tasks, nthreads, threads, started);
+        for (int i = 0; i < nthreads; i++) slots += tasks[i].nslots;
+        ok = slots <= INT_MAX;
+    }
+    if (ok) {
+        ds->records = malloc((size_t)slots * sizeof *ds->records);
+        ok = ds->records != NULL;
+    }
+
+    if (ok) {
+        RECORD *slice = ds->records;
+        for (int i = 0; i < nthreads; i++) {
+            tasks[i].slots = slice;
+            slice += tasks[i].nslots;
+        }
+        run_tasks(import_worker, tasks, nthreads, threads, started);
+
+        long long total = 0;
+        int spilled = 0;
+        for (int i = 0; i < nthreads; i++) {
+            ok = ok && tasks[i].ok;
+            total += tasks[i].count + tasks[i].overflow.count;
+            spilled |= tasks[i].overflow.count > 0;
+        }
+        ok = ok && total <= INT_MAX;
+
+        if (ok && spilled) {
+            // rare: splice the spilled records in through a fresh array
+            RECORD *r = malloc((size_t)total * sizeof *r);
+            ok = r != NULL;
+            for (int i = 0, n = 0; ok && i < nthreads; i++) {
+                memcpy(r + n, tasks[i].slots, (size_t)tasks[i].count * sizeof *r);
+                n += tasks[i].count;
+                memcpy(r + n, tasks[i].overflow.records, (size_t)tasks[i].overflow.count * sizeof *r);
+                n += tasks[i].overflow.count;
+            }
+            if (ok) {
+                free(ds->records);
+                ds->records = r;
+                ds->count = ds->capacity = (int)total;
+            }
+        } else if (ok) {
+            for (int i = 0; i < nthreads; i++) {
+                if (tasks[i].slots != ds->records + ds->count)
+                    memmove(ds->records + ds->count, tasks[i].slots,
+                            (size_t)tasks[i].count * sizeof *ds->records);
+                ds->count += tasks[i].count;
+            }
+            ds->capacity = (int)slots;
+        }
+    }
+
+    if (tasks)
+        for (int i = 0; i < nthreads; i++) free(tasks[i].overflow.records);
+    free(tasks);
+    free(threads);
+    free(started);
+    unmap_stream(fp, &m);
+    if (!ok) {
+        dataset_free(ds);
+        return NULL;
+    }
+    return ds;
+}
+
+/*
+ *  Release a dataset and its records.
+ *
+ *  @param *ds - dataset from import_dataset, may be NULL.
+ */
+void dataset_free(DATASET *ds) {
+    if (!ds) return;
+    free(ds->records);
+    free(ds);
+}
+
+/*
+ *  Stream the scores of a record file into a t-digest without storing the
+ *  records, so quantiles of arbitrarily large files fit in fixed memory.
+ *
+ *  @param *fp -  FILE pointer to intput file.
+ *  @param *td - digest to add the scores to.
+ *  @return   - number of records read
+ */
+long long import_scores(FILE *fp, TDIGEST *td) {
+    if (!fp || !td) return 0;
+
+    char line[256];
+    long long n = 0;
+    RECORD r;
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (parse_record(line, &r)) {
+            tdigest_add(td, r.score);
+            n++;
+        }
+    }
+
+    return n;
+}
+
+/*
+ *  Median of v[0..n-1] by O(n) selection; reorders v. For even n it is the
+ *  mean of the two middle values.
+ *
+ *  @param *v - the scores, reordered.
+ *  @param n - number of scores, at least 1.
+ *  @return - the median.
+ */
+float select_median(float *v, int n) {
+    float_select(v, n, n / 2);
+    float median = v[n / 2];
+    if (n % 2 == 0) {
+        // the lower middle value is the largest one left of v[n/2]
+        float lower = v[0];
+        for (int i = 1; i < n / 2; i++)
+            if (v[i] > lower) lower = v[i];
+        median = (lower + median) / 2.0f;
+    }
+    return median;
+}
+
+/*
+ *  STATS of the n scores in v; reorders v.
+ */
+static STATS score_stats(float *v, int n) {
+    STATS stats;
+    MOMENTS m = moments_parallel(v, n, 0);
+
+    stats.count = n;
+    stats.mean = (float)m.mean;
+    stats.stddev = (float)moments_stddev(&m);
+    stats.median = select_median(v, n);
+    return stats;
+}
+
+/*
+ *  Set up an empty histogram: grades on scale (NULL for the default) and
+ *  nbuckets equal score buckets over [lo, hi). Scores below lo count in the
+ *  first bucket and scores from hi up in the last.
+ *
+ *  @param *hist - histogram to set up.
+ *  @param *scale - grading scale to count letter grades on.
+ *  @param lo, hi - score range of the buckets.
+ *  @param nbuckets - number of buckets, clamped to 1..HIST_MAX_BUCKETS.
+ */
+void histogram_init(HISTOGRAM *hist, const GRADE_SCALE *scale, float lo, float hi, int nbuckets) {
+    memset(hist, 0, sizeof *hist);
+    if (nbuckets < 1) nbuckets = 1;
+    if (nbuckets > HIST_MAX_BUCKETS) nbuckets = HIST_MAX_BUCKETS;
+    hist->scale = scale ? scale : &grade_scale_default;
+    hist->bucket_lo = lo;
+    hist->bucket_width = (hi - lo) / nbuckets;
+    hist->nbuckets = nbuckets;
+}
+
+// bucket of a score: floor((s - lo) / width) clamped to the range, NaN in the first
+static int bucket_of(const HISTOGRAM *hist, float s) {
+    float f = (s - hist->bucket_lo) / hist->bucket_width;
+    if (!(f >= 0)) return 0;
+    if (f >= hist->nbuckets) return hist->nbuckets - 1;
+    return (int)f;
+}
+
+#define SCAN_BLOCK 4096
+#define SCAN_MIN_CHUNK (1 << 18)
+
+typedef struct {
+    const RECORD *records;
+    float *scores;
+    long long n;
+    HISTOGRAM *hist;        // NULL when only moments are wanted
+    MOMENTS m;
+} SCAN_TASK;
+
+/*
+ *  One pass over a chunk of records, a block at a time: gather the scores
+ *  into the contiguous buffer and, while the block is in cache, reduce its
+ *  moments and count its grades and buckets.
+ */
+static void *scan_worker(void *arg) {
+    SCAN_TASK *t = arg;
+    uint8_t ids[SCAN_BLOCK];
+    MOMENTS m = {0, 0.0, 0.0};
+
+    for (long long i = 0; i < t->n; i += SCAN_BLOCK) {
+        int len = t->n - i < SCAN_BLOCK ? (int)(t->n - i) : SCAN_BLOCK;
+        float *v = t->scores + i;
+        for (int j = 0; j < len; j++)
+            v[j] = t->records[i + j].score;
+
+        MOMENTS b = moments_of(v, len);
+        moments_merge(&m, &b);
+
+        if (t->hist) {
+            grade_many_scale(t->hist->scale, v, len, ids);
+            for (int j = 0; j < len; j++) {
+                t->hist->grade_count[ids[j]]++;
+                t->hist->bucket_count[bucket_of(t->hist, v[j])]++;
+            }
+        }
+    }
+    t->m = m;
+    return NULL;
+}
+
+/*
+ *  Run scan_worker over n records in one contiguous chunk per thread, the
+ *  calling thread taking the first. Per-thread moments and histograms are
+ *  merged in chunk order, so the result does not depend on thread timing.
+ */
+static int scan_records(const RECORD *dataset, float *scores, long long n, HISTOGRAM *hist, MOMENTS *m) {
+    int nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > n / SCAN_MIN_CHUNK) nthreads = (int)(n / SCAN_MIN_CHUNK);
+    if (nthreads < 1) nthreads = 1;
+
+    SCAN_TASK *tasks = calloc(nthreads, sizeof *tasks);
+    HISTOGRAM *local = hist ? calloc(nthreads, sizeof *local) : NULL;
+    pthread_t *threads = malloc(nthreads * sizeof *threads);
+    int *started = calloc(nthreads, sizeof *started);
+    if (!tasks || (hist && !local) || !threads || !started) {
+        free(tasks);
+        free(local);
+        free(threads);
+        free(started);
+        return 0;
+    }
+
+    long long chunk = n / nthreads;
+    for (int i = 0; i < nthreads; i++) {
+        tasks[i].records = dataset + i * chunk;
+        tasks[i].scores = scores + i * chunk;
+        tasks[i].n = (i == nthreads - 1) ? n - i * chunk : chunk;
+        if (hist) {
+            local[i] = *hist;
+            tasks[i].hist = &local[i];
+        }
+    }
+    for (int i = 1; i < nthreads; i++)
+        started[i] = pthread_create(&threads[i], NULL, scan_worker, &tasks[i]) == 0;
+    scan_worker(&tasks[0]);
+
+    *m = tasks[0].m;
+    for (int i = 1; i < nthreads; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            scan_worker(&tasks[i]);
+        moments_merge(m, &tasks[i].m);
+    }
+    if (hist) {
+        for (int i = 0; i < nthreads; i++) {
+            for (int g = 0; g <= GRADE_MAX_CUTOFFS; g++)
+                hist->grade_count[g] += local[i].grade_count[g];
+            for (int b = 0; b < HIST_MAX_BUCKETS; b++)
+                hist->bucket_count[b] += local[i].bucket_count[b];
+        }
+    }
+
+    free(tasks);
+    free(local);
+    free(threads);
+    free(started);
+    return 1;
 }
 
 /*
  *  Take the RECORD data array as input, compute the average score, standard deviation,
  *  median of the score values of the record data, and returns the STATS type value.
+ *  One parallel pass copies the scores into a contiguous heap buffer block by
+ *  block and reduces the mean and standard deviation from each block while
+ *  it is in cache; the median is then selected in O(n) from the buffer.
  *
  *  @param dataset -  input record data array.
  *  @param count -  the number of data record in dataset array.
- *  @return  -  stats value in STATS type.
+ *  @return  -  stats value in STATS type; all zero if n <= 0 or out of memory.
  */
 STATS process_data(RECORD *dataset, int n) {
+    return process_data_hist(dataset, n, NULL);
+}
+
+/*
+ *  process_data that also fills a histogram of letter grades and score
+ *  buckets in the same pass over the records.
+ *
+ *  @param dataset -  input record data array.
+ *  @param count -  the number of data record in dataset array.
+ *  @param *hist - histogram set up by histogram_init, counts are replaced;
+ *                 NULL to skip.
+ *  @return  -  stats value in STATS type; all zero if n <= 0 or out of memory.
+ */
+STATS process_data_hist(RECORD *dataset, int n, HISTOGRAM *hist) {
     STATS stats = {0};
 
+    if (hist) {
+        memset(hist->grade_count, 0, sizeof hist->grade_count);
+        memset(hist->bucket_count, 0, sizeof hist->bucket_count);
+    }
     if (dataset == NULL || n <= 0)
         return stats;
 
-    float sum = 0.0f;
-    for (int i = 0; i < n; i++)
-        sum += dataset[i].score;
-    float mean = sum / n;
+    float *scores = malloc((size_t)n * sizeof *scores);
+    MOMENTS m;
+    if (scores == NULL || !scan_records(dataset, scores, n, hist, &m)) {
+        free(scores);
+        return stats;
+    }
+
+    stats.count = n;
+    stats.mean = (float)m.mean;
+    stats.stddev = (float)moments_stddev(&m);
+    stats.median = select_median(scores, n);
+    free(scores);
+    return stats;
+}
 
-    float var_sum = 0.0f;
+/*
+ *  Sort the gathered pairs, write their indexes to perm and free p.
+ */
+static int keypair_order(KEYPAIR *p, int n, int descending, uint32_t *perm) {
+    int ok = descending ? pair_sort_desc(p, n) : pair_sort(p, n);
+    if (ok) {
+        for (int i = 0; i < n; i++)
+            perm[i] = p[i].index;
+    }
+    free(p);
+    return ok;
+}
+
+/*
+ *  Compute the order of the records by score without moving them: gather
+ *  (score, index) pairs into one contiguous buffer and sort that, so the sort
+ *  never dereferences into the dataset.
+ *
+ *  @param *dataset - pointer to dataset array.
+ *  @param n - the number of data record in dataset array.
+ *  @param descending - nonzero for decreasing score order.
+ *  @param *perm - output array of n indexes; dataset[perm[0]] comes first.
+ *  @return - 1 if successful; 0 if n < 1 or out of memory.
+ */
+int record_order(const RECORD *dataset, int n, int descending, uint32_t *perm) {
+    if (!dataset || !perm || n < 1) return 0;
+
+    KEYPAIR *p = malloc((size_t)n * sizeof *p);
+    if (!p) return 0;
     for (int i = 0; i < n; i++) {
-        float diff = dataset[i].score - mean;
-        var_sum += diff * diff;
+        p[i].key = dataset[i].score;
+        p[i].index = (uint32_t)i;
     }
-    float stddev = sqrt(var_sum / n);
+    return keypair_order(p, n, descending, perm);
+}
 
-    void *a[n]; 
-    for (int i = 0; i < n; i++)
-        a[i] = &dataset[i].score;
+/*
+ *  Reorder the records in place by score, moving each record once by
+ *  following the cycles of the permutation from record_order. The order is
+ *  stable, equal scores keeping their input order, which the external sort
+ *  relies on to match report_data; so if the scratch buffers cannot be
+ *  allocated the records are left as they are and 0 is returned, rather than
+ *  falling back to an unstable sort.
+ *
+ *  @param *dataset - pointer to dataset array.
+ *  @param n - the number of data record in dataset array.
+ *  @param descending - nonzero for decreasing score order.
+ *  @return - 1 if successful; 0 if n < 1 or out of memory.
+ */
+int sort_records(RECORD *dataset, int n, int descending) {
+    if (!dataset || n < 1) return 0;
 
-    select_sort(a, 0, n - 1);  
+    uint32_t *perm = malloc((size_t)n * sizeof *perm);
+    if (!perm || !record_order(dataset, n, descending, perm)) {
+        free(perm);
+        return 0;
+    }
 
-    float median;
-    if (n % 2 == 1)
-        median = *(float *)a[n / 2];
-    else
-        median = (*(float *)a[n / 2 - 1] + *(float *)a[n / 2]) / 2.0f;
+    for (uint32_t i = 0; i < (uint32_t)n; i++) {
+        if (perm[i] == i) continue;
+        RECORD tmp = dataset[i];
+        uint32_t j = i;
+        while (perm[j] != i) {
+            uint32_t k = perm[j];
+            dataset[j] = dataset[k];
+            perm[j] = j;
+            j = k;
+        }
+        dataset[j] = tmp;
+        perm[j] = j;
+    }
 
-    stats.count = n;
-    stats.mean = mean;
-    stats.stddev = stddev;
-    stats.median = median;
+    free(perm);
+    return 1;
+}
 
-    return stats;
+
+/*
+ *  Write score as printf("%.1f") would, returning the end of the text. The
+ *  float widened to double and times 10 is exact (24 + 4 bits), so rounding
+ *  that product to an integer with nearbyint, which ties to even as printf
+ *  does, gives the same digits; the sign follows the sign bit, so small
+ *  negatives print "-0.0" as printf does. Large and non-finite values go to
+ *  snprintf.
+ */
+static char *format_score(char *out, float score) {
+    double v = score;
+    if (!(fabs(v) < 1e15))
+        return out + snprintf(out, REPORT_LINE_MAX / 2, "%.1f", v);
+
+    if (signbit(v)) {
+        *out++ = '-';
+        v = -v;
+    }
+    uint64_t q = (uint64_t)nearbyint(v * 10);
+    uint64_t whole = q / 10;
+
+    char digits[20];
+    int k = 0;
+    do {
+        digits[k++] = (char)('0' + whole % 10);
+        whole /= 10;
+    } while (whole);
+    while (k)
+        *out++ = digits[--k];
+    *out++ = '.';
+    *out++ = (char)('0' + q % 10);
+    return out;
 }
 
+/*
+ *  Format one report line, "name:score,grade\n" with the score as "%.1f",
+ *  at out; at most REPORT_LINE_MAX bytes, not NUL-terminated.
+ *
+ *  @param *out - where to write.
+ *  @param *r - the record.
+ *  @return - the end of the line written
+ */
+char *format_record(char *out, const RECORD *r) {
+    const char *letter = grade_scale_default.letters[grade_id(&grade_scale_default, r->score)].letter_grade;
+
+    for (int k = 0; k < (int)sizeof r->name && r->name[k]; k++)
+        *out++ = r->name[k];
+    *out++ = ':';
+    out = format_score(out, r->score);
+    *out++ = ',';
+    while (*letter)
+        *out++ = *letter++;
+    *out++ = '\n';
+    return out;
+}
 
 /*
  *  This function takes output file named outfilename, RECORD array records, 
  *  and stats as inputs, prepare and write report of stats and grade to files.
- *  The records in report file are sorted in decreasing of scores.  
+ *  The records in report file are sorted in decreasing of scores; records with
+ *  equal scores keep their input order. Record lines are formatted into a
+ *  64 KB stack buffer with a fixed one-decimal formatter and the grade table,
+ *  and written with one fwrite per buffer, instead of one fprintf each.
  *
  *  @param *fp -  FILE pointer to output file.
  *  @param *dataset - pointer to dataset array.
  *  @param stats - the stats value to be used in report.
- *  @return - returns 1 if successful; 0 if count < 1
+ *  @return - returns 1 if successful; 0 if count < 1, out of memory or a
+ *            write fails
  */
-static int cmp2(void *x, void *y) {
-    float b = ((RECORD *)x)->score;
-    float a = ((RECORD *)y)->score;
-    if (a > b) return 1;        
-    else if (a < b) return -1;
-    else return 0;
-}
-
 int report_data(FILE *fp, RECORD *dataset, STATS stats) {
     if (!fp || !dataset || stats.count < 1) return 0;
 
     int n = stats.count;
+    uint32_t *perm = malloc((size_t)n * sizeof *perm);
+    if (!perm || !record_order(dataset, n, 1, perm)) {
+        free(perm);
+        return 0;
+    }
 
     fprintf(fp, "Record count: %d\n", n);
     fprintf(fp, "Average: %.2f\n", stats.mean);
@@ -168,17 +1022,263 @@ int report_data(FILE *fp, RECORD *dataset, STATS stats) {
     fprintf(fp, "Median: %.2f\n", stats.median);
     fprintf(fp, "\n");
 
-    RECORD *p[n];
-    for (int i = 0; i < n; i++) {
-        p[i] = &dataset[i];
+    // lines are formatted into buf and written in large blocks
+    char buf[REPORT_BUFFER];
+    char *out = buf;
+    int ok = 1;
+    for (int i = 0; i < n && ok; i++) {
+        out = format_record(out, &dataset[perm[i]]);
+        if (out > buf + REPORT_BUFFER - REPORT_LINE_MAX) {
+            ok = fwrite(buf, 1, out - buf, fp) == (size_t)(out - buf);
+            out = buf;
+        }
     }
+    if (ok && out > buf)
+        ok = fwrite(buf, 1, out - buf, fp) == (size_t)(out - buf);
 
-    my_sort((void **)p, 0, n - 1, cmp2);
+    free(perm);
+    return ok;
+}
 
-    for (int i = 0; i < n; i++) {
-        GRADE g = grade(p[i]->score);
-        fprintf(fp, "%s:%.1f,%s\n", p[i]->name, p[i]->score, g.letter_grade);
+/*
+ *  Write a histogram as "letter: count" lines for each grade from highest to
+ *  lowest, then "[lo, hi): count" lines for each score bucket.
+ *
+ *  @param *fp -  FILE pointer to output file.
+ *  @param *hist - the histogram.
+ *  @return - 1 if successful; 0 if fp or hist is NULL
+ */
+int report_histogram(FILE *fp, const HISTOGRAM *hist) {
+    if (!fp || !hist || !hist->scale) return 0;
+
+    fprintf(fp, "Grade distribution\n");
+    for (int g = scale_cutoffs(hist->scale); g >= 0; g--)
+        fprintf(fp, "%s: %d\n", hist->scale->letters[g].letter_grade, hist->grade_count[g]);
+    fprintf(fp, "\nScore buckets\n");
+    for (int b = 0; b < hist->nbuckets; b++) {
+        float lo = hist->bucket_lo + b * hist->bucket_width;
+        fprintf(fp, "[%.1f, %.1f): %d\n", lo, lo + hist->bucket_width, hist->bucket_count[b]);
     }
+    return 1;
+}
+
+/*
+ *  report_data followed by a blank line and the histogram. report_data keeps
+ *  its exact format for existing readers of the report.
+ *
+ *  @param *fp -  FILE pointer to output file.
+ *  @param *dataset - pointer to dataset array.
+ *  @param stats - the stats value to be used in report.
+ *  @param *hist - histogram from process_data_hist.
+ *  @return - returns 1 if successful; 0 if count < 1 or out of memory
+ */
+int report_data_hist(FILE *fp, RECORD *dataset, STATS stats, const HISTOGRAM *hist) {
+    if (!report_data(fp, dataset, stats)) return 0;
+    fprintf(fp, "\n");
+    return report_histogram(fp, hist);
+}
+
+/*
+ *  process_data over a dataset from import_dataset.
+ *
+ *  @param *ds -  the dataset.
+ *  @return  -  stats value in STATS type; all zero if ds is NULL or empty.
+ */
+STATS process_dataset(DATASET *ds) {
+    STATS stats = {0};
+    if (ds == NULL) return stats;
+    return process_data(ds->records, ds->count);
+}
 
+/*
+ *  report_data over a dataset from import_dataset; the report is identical.
+ *
+ *  @param *fp -  FILE pointer to output file.
+ *  @param *ds - the dataset.
+ *  @param stats - the stats value to be used in report.
+ *  @return - returns 1 if successful; 0 if ds is NULL, empty or out of memory
+ */
+int report_dataset(FILE *fp, DATASET *ds, STATS stats) {
+    if (ds == NULL || stats.count > ds->count) return 0;
+    return report_data(fp, ds->records, stats);
+}
+
+#define RECORDSET_MIN_CAPACITY 1024
+
+/*
+ *  Make room for one more record with a name of len bytes, doubling the
+ *  columns and the name buffer as needed. Return 0 if out of memory.
+ */
+static int recordset_reserve(RECORDSET *rs, size_t len) {
+    if (rs->count == rs->capacity) {
+        if (rs->capacity > INT_MAX / 2) return 0;
+        int cap = rs->capacity ? rs->capacity * 2 : RECORDSET_MIN_CAPACITY;
+        float *s = realloc(rs->scores, (size_t)cap * sizeof *s);
+        if (!s) return 0;
+        rs->scores = s;
+        uint32_t *o = realloc(rs->name_off, (size_t)cap * sizeof *o);
+        if (!o) return 0;
+        rs->name_off = o;
+        rs->capacity = cap;
+    }
+    if (rs->names_len + len + 1 > rs->names_cap) {
+        size_t cap = rs->names_cap ? rs->names_cap : (size_t)RECORDSET_MIN_CAPACITY * 8;
+        while (rs->names_len + len + 1 > cap) cap *= 2;
+        if (cap > UINT32_MAX) return 0;
+        char *b = realloc(rs->names, cap);
+        if (!b) return 0;
+        rs->names = b;
+        rs->names_cap = cap;
+    }
     return 1;
 }
+
+/*
+ *  Append one record; the name is truncated to fit a RECORD, as import_data
+ *  does, so conversions both ways are exact.
+ */
+static int recordset_append(RECORDSET *rs, const char *name, size_t len, float score) {
+    if (len > sizeof(((RECORD *)0)->name) - 1) len = sizeof(((RECORD *)0)->name) - 1;
+    if (!recordset_reserve(rs, len)) return 0;
+
+    memcpy(rs->names + rs->names_len, name, len);
+    rs->names[rs->names_len + len] = '\0';
+    rs->name_off[rs->count] = (uint32_t)rs->names_len;
+    rs->scores[rs->count] = score;
+    rs->names_len += len + 1;
+    rs->count++;
+    return 1;
+}
+
+/*
+ *  Import every record of a file straight into columns: scores go to one
+ *  contiguous float array and names to a packed buffer, without building
+ *  RECORDs. The records are the same as import_data gives.
+ *
+ *  @param *fp -  FILE pointer to intput file.
+ *  @return   - the record set, or NULL if fp is NULL or memory runs out
+ */
+RECORDSET *import_recordset(FILE *fp) {
+    if (!fp) return NULL;
+    RECORDSET *rs = calloc(1, sizeof *rs);
+    if (!rs) return NULL;
+
+    MAPPED m;
+    int ok = 1;
+    const char *name;
+    size_t len;
+    float score;
+    if (map_stream(fp, &m)) {
+        for (const char *p = m.p, *stop; p < m.end && ok; p = stop) {
+            stop = chunk_end(p, m.end);
+            if (parse_fields(p, stop, &name, &len, &score))
+                ok = recordset_append(rs, name, len, score);
+        }
+        unmap_stream(fp, &m);
+    } else {
+        char line[256];
+        while (ok && fgets(line, sizeof(line), fp)) {
+            if (parse_fields(line, line + strlen(line), &name, &len, &score))
+                ok = recordset_append(rs, name, len, score);
+        }
+    }
+
+    if (!ok) {
+        recordset_free(rs);
+        return NULL;
+    }
+    return rs;
+}
+
+/*
+ *  Build a record set from a RECORD array.
+ *
+ *  @param *dataset - pointer to dataset array.
+ *  @param n - the number of data record in dataset array.
+ *  @return   - the record set, or NULL if out of memory
+ */
+RECORDSET *recordset_from_records(const RECORD *dataset, int n) {
+    RECORDSET *rs = calloc(1, sizeof *rs);
+    if (!rs) return NULL;
+    for (int i = 0; i < n; i++) {
+        const RECORD *r = &dataset[i];
+        if (!recordset_append(rs, r->name, strnlen(r->name, sizeof r->name), r->score)) {
+            recordset_free(rs);
+            return NULL;
+        }
+    }
+    return rs;
+}
+
+/*
+ *  Copy a record set back into a RECORD array, names zero-padded as
+ *  import_data leaves them.
+ *
+ *  @param *rs - the record set.
+ *  @param dataset - array of at least rs->count RECORDs.
+ *  @return   - number of records written
+ */
+int recordset_to_records(const RECORDSET *rs, RECORD *dataset) {
+    if (!rs || !dataset) return 0;
+    for (int i = 0; i < rs->count; i++) {
+        memset(dataset[i].name, 0, sizeof dataset[i].name);
+        strcpy(dataset[i].name, rs->names + rs->name_off[i]);
+        dataset[i].score = rs->scores[i];
+    }
+    return rs->count;
+}
+
+/*
+ *  Release a record set and its columns.
+ *
+ *  @param *rs - record set, may be NULL.
+ */
+void recordset_free(RECORDSET *rs) {
+    if (!rs) return;
+    free(rs->scores);
+    free(rs->name_off);
+    free(rs->names);
+    free(rs);
+}
+
+/*
+ *  process_data over a record set. The score column is already contiguous,
+ *  so it is copied with one memcpy for the median selection instead of a
+ *  strided gather.
+ *
+ *  @param *rs -  the record set.
+ *  @return  -  stats value in STATS type; all zero if empty or out of memory.
+ */
+STATS process_recordset(const RECORDSET *rs) {
+    STATS stats = {0};
+    if (rs == NULL || rs->count <= 0) return stats;
+
+    float *scores = malloc((size_t)rs->count * sizeof *scores);
+    if (scores == NULL) return stats;
+    memcpy(scores, rs->scores, (size_t)rs->count * sizeof *scores);
+
+    stats = score_stats(scores, rs->count);
+    free(scores);
+    return stats;
+}
+
+/*
+ *  record_order over a record set.
+ *
+ *  @param *rs - the record set.
+ *  @param descending - nonzero for decreasing score order.
+ *  @param *perm - output array of rs->count indexes.
+ *  @return - 1 if successful; 0 if empty or out of memory.
+ */
+int recordset_order(const RECORDSET *rs, int descending, uint32_t *perm) {
+    if (!rs || !perm || rs->count < 1) return 0;
+
+    int n = rs->count;
+    KEYPAIR *p = malloc((size_t)n * sizeof *p);
+    if (!p) return 0;
+    for (int i = 0; i < n; i++) {
+        p[i].key = rs->scores[i];
+        p[i].index = (uint32_t)i;
+    }
+    return keypair_order(p, n, descending, perm);
+}
@@ -5,6 +5,9 @@
  #ifndef MYRECORD_H
  #define MYRECORD_H 
  
+ #include <stdint.h>
+ #include "mystats.h"
+ 
  typedef struct {
    char name[20];
    float score;
@@ -21,12 +24,125 @@
    char letter_grade[3];
  } GRADE;
  
+ // records that grow geometrically as a file is imported
+ typedef struct {
+   RECORD *records;
+   int count;
+   int capacity;
+ } DATASET;
+ 
+ #define GRADE_MAX_CUTOFFS 15
+ 
+ // a grading scale: a score reaching cutoff[i - 1] but not cutoff[i] earns
+ // letters[i]; cutoffs are increasing, letters[0] is below every cutoff.
+ // count is clamped to [0, GRADE_MAX_CUTOFFS] wherever a scale is used
+ typedef struct {
+   int count;
+   float cutoff[GRADE_MAX_CUTOFFS];
+   GRADE letters[GRADE_MAX_CUTOFFS + 1];
+ } GRADE_SCALE;
+ 
+ extern const GRADE_SCALE grade_scale_default;
+ 
  GRADE grade(float score);
  
+ // grade n scores into ids indexing grade_scale_default.letters
+ void grade_many(const float *scores, int n, uint8_t *grade_ids);
+ 
+ // grade_many on another scale; NULL selects the default
+ void grade_many_scale(const GRADE_SCALE *scale, const float *scores, int n, uint8_t *grade_ids);
+ 
  int import_data(FILE *fp, RECORD *dataset); 
  
+ // read at most max records; 0 at end of file
+ int read_records(FILE *fp, RECORD *dataset, int max);
+ 
+ // import_data over a memory-mapped file; same records, much faster on large files
+ int import_data_mmap(FILE *fp, RECORD *dataset);
+ 
+ // stream a record file's scores into a quantile digest; number of records read
+ long long import_scores(FILE *fp, TDIGEST *td);
+ 
  STATS process_data(RECORD *dataset, int count);
  
+ // median of v[0..n-1] as process_data computes it; reorders v
+ float select_median(float *v, int n);
+ 
  int report_data(FILE *fp,  RECORD *dataset, STATS stats);
  
+ #define REPORT_BUFFER (1 << 16)
+ #define REPORT_LINE_MAX 128     // a formatted line always fits
+ 
+ // format one "name:score,grade" report line at out; returns its end
+ char *format_record(char *out, const RECORD *r);
+ 
+ #define HIST_MAX_BUCKETS 32
+ 
+ // records per letter grade of a scale and per equal-width score bucket;
+ // bucket i covers [bucket_lo + i * bucket_width, bucket_lo + (i + 1) * bucket_width)
+ typedef struct {
+   const GRADE_SCALE *scale;
+   int grade_count[GRADE_MAX_CUTOFFS + 1];
+   float bucket_lo, bucket_width;
+   int nbuckets;
+   int bucket_count[HIST_MAX_BUCKETS];
+ } HISTOGRAM;
+ 
+ // set up an empty histogram; scale NULL for the default
+ void histogram_init(HISTOGRAM *hist, const GRADE_SCALE *scale, float lo, float hi, int nbuckets);
+ 
+ // process_data that also counts grades and buckets in the same pass
+ STATS process_data_hist(RECORD *dataset, int count, HISTOGRAM *hist);
+ 
+ // write the histogram section of a report
+ int report_histogram(FILE *fp, const HISTOGRAM *hist);
+ 
+ // report_data followed by the histogram section
+ int report_data_hist(FILE *fp, RECORD *dataset, STATS stats, const HISTOGRAM *hist);
+ 
+ int record_order(const RECORD *dataset, int n, int descending, uint32_t *perm);
+ 
+ // stable sort by score in place; 0 if out of memory, records left unchanged
+ int sort_records(RECORD *dataset, int n, int descending);
+ 
+ // import a whole file into a new growable dataset; NULL if out of memory
+ DATASET *import_dataset(FILE *fp);
+ 
+ // import_dataset over byte ranges parsed by nthreads threads (<= 0: one per CPU)
+ DATASET *import_dataset_parallel(FILE *fp, int nthreads);
+ 
+ // release a dataset and its records in one call
+ void dataset_free(DATASET *ds);
+ 
+ // process_data and report_data over a dataset
+ STATS process_dataset(DATASET *ds);
+ 
+ int report_dataset(FILE *fp, DATASET *ds, STATS stats);
+ 
+ // records as columns: scores contiguous for SIMD scans, names packed in one
+ // buffer; the name of record i is names + name_off[i]
+ typedef struct {
+   float *scores;
+   uint32_t *name_off;
+   char *names;
+   int count, capacity;
+   size_t names_len, names_cap;
+ } RECORDSET;
+ 
+ // import a whole file into a new record set; NULL if out of memory
+ RECORDSET *import_recordset(FILE *fp);
+ 
+ // convert from and to RECORD arrays
+ RECORDSET *recordset_from_records(const RECORD *dataset, int n);
+ 
+ int recordset_to_records(const RECORDSET *rs, RECORD *dataset);
+ 
+ // release a record set
+ void recordset_free(RECORDSET *rs);
+ 
+ // process_data and record_order over a record set
+ STATS process_recordset(const RECORDSET *rs);
+ 
+ int recordset_order(const RECORDSET *rs, int descending, uint32_t *perm);
+ 
  #endif
\ No newline at end of file
@@ -38,6 +38,40 @@ void test_grade() {
 	printf("\n");
 }
 
+void test_grade_many() {
+	printf("------------------\n");
+	printf("Test: grade_many\n\n");
+
+	int count = sizeof(grade_tests) / sizeof *grade_tests;
+	uint8_t ids[sizeof(grade_tests) / sizeof *grade_tests];
+	grade_many(grade_tests, count, ids);
+	for (int i = 0; i < count; i++) {
+		printf("grade_many(%.1f): %s\n", grade_tests[i],
+				grade_scale_default.letters[ids[i]].letter_grade);
+	}
+
+	GRADE_SCALE pass_fail = {1, {60}, {{"F"}, {"P"}}};
+	grade_many_scale(&pass_fail, grade_tests, count, ids);
+	printf("pass/fail:");
+	for (int i = 0; i < count; i++)
+		printf(" %s", pass_fail.letters[ids[i]].letter_grade);
+	printf("\n");
+
+	// a count past GRADE_MAX_CUTOFFS uses only the cutoffs the scale holds
+	GRADE_SCALE oversized = grade_scale_default;
+	oversized.count = 1000;
+	for (int k = grade_scale_default.count; k < GRADE_MAX_CUTOFFS; k++)
+		oversized.cutoff[k] = 1000;
+	uint8_t ref[sizeof(grade_tests) / sizeof *grade_tests];
+	grade_many(grade_tests, count, ref);
+	grade_many_scale(&oversized, grade_tests, count, ids);
+	float top = 2000;
+	uint8_t top_id;
+	grade_many_scale(&oversized, &top, 1, &top_id);
+	printf("count 1000 grades like the default scale: %s, 2000 gets id %d\n\n",
+			memcmp(ids, ref, count) == 0 ? "yes" : "no", top_id);
+}
+
 void test_import_data() {
 	printf("------------------\n");
 	printf("Test: import_data\n\n");
@@ -55,6 +89,47 @@ void test_import_data() {
 	printf("\n");
 }
 
+void test_import_data_mmap() {
+	printf("------------------\n");
+	printf("Test: import_data_mmap\n\n");
+
+	RECORD expect[MAX_REC], dataset[MAX_REC];
+	memset(expect, 0, sizeof expect);
+	memset(dataset, 0, sizeof dataset);
+	FILE *fp = fopen(infilename, "r");
+	if (fp == NULL) {
+		perror("open input file error");
+		return;
+	}
+	int n = import_data(fp, expect);
+	rewind(fp);
+	int count = import_data_mmap(fp, dataset);
+	fclose(fp);
+	printf("import_data_mmap():%d\n", count);
+	printf("same as import_data: %s\n",
+			count == n && memcmp(expect, dataset, n * sizeof *dataset) == 0 ? "yes" : "no");
+	printf("\n");
+}
+
+void test_import_scores() {
+	printf("------------------\n");
+	printf("Test: import_scores\n\n");
+
+	TDIGEST *td = tdigest_create(0);
+	FILE *fp = fopen(infilename, "r");
+	if (!td || !fp) {
+		perror("open input file error");
+		tdigest_free(td);
+		return;
+	}
+	long long count = import_scores(fp, td);
+	fclose(fp);
+	printf("import_scores():%lld\n", count);
+	printf("median:%.2f p90:%.2f\n", tdigest_quantile(td, 0.5), tdigest_quantile(td, 0.9));
+	tdigest_free(td);
+	printf("\n");
+}
+
 void test_process_data() {
 	printf("------------------\n");
 	printf("Test: process_data\n\n");
@@ -77,6 +152,25 @@ void test_process_data() {
 	printf("\n");
 }
 
+void test_sort_records() {
+	printf("------------------\n");
+	printf("Test: sort_records\n\n");
+	RECORD dataset[MAX_REC]; // declare array of RECORD to store record data
+	FILE *fp = fopen(infilename, "r");
+	if (fp == NULL) {
+		perror("open input file error");
+		return;
+	}
+	int count = import_data(fp, dataset);
+	fclose(fp);
+	if (count > 0 && sort_records(dataset, count, 1)) {
+		for (int i = 0; i < count; i++) {
+			printf(data_format, dataset[i].name, dataset[i].score);
+		}
+	}
+	printf("\n");
+}
+
 void test_report_data() {
 	printf("------------------\n");
 	printf("Test: report_data\n\n");
@@ -113,10 +207,200 @@ void test_report_data() {
 	printf("\n");
 }
 
+void test_import_dataset() {
+	printf("------------------\n");
+	printf("Test: import_dataset\n\n");
+	FILE *fp = fopen(infilename, "r");
+	if (fp == NULL) {
+		perror("open input file error");
+		return;
+	}
+	DATASET *ds = import_dataset(fp);
+	fclose(fp);
+	if (ds == NULL) {
+		printf("import_dataset(): out of memory\n");
+		return;
+	}
+	printf("import_dataset():%d\n", ds->count);
+
+	STATS stats = process_dataset(ds);
+	printf(stats_title);
+	printf(stats_format, "count", (float) stats.count);
+	printf(stats_format, "mean", stats.mean);
+	printf(stats_format, "stddev", stats.stddev);
+	printf(stats_format, "median", stats.median);
+
+	// the report must match report_data's byte for byte
+	char *buf = NULL;
+	size_t len = 0;
+	FILE *out = tmpfile();
+	if (out && report_dataset(out, ds, stats)) {
+		len = ftell(out);
+		buf = malloc(len + 1);
+		rewind(out);
+		if (buf) buf[fread(buf, 1, len, out)] = '\0';
+	}
+	if (out) fclose(out);
+	fp = fopen(outfilename, "r");
+	int same = 0;
+	if (fp && buf) {
+		char *expect = malloc(len + 2);
+		size_t got = expect ? fread(expect, 1, len + 1, fp) : 0;
+		same = expect && got == len && memcmp(expect, buf, len) == 0;
+		free(expect);
+	}
+	if (fp) fclose(fp);
+	printf("report_dataset same as report_data: %s\n", same ? "yes" : "no");
+
+	free(buf);
+	dataset_free(ds);
+	printf("\n");
+}
+
+void test_import_dataset_parallel() {
+	printf("------------------\n");
+	printf("Test: import_dataset_parallel\n\n");
+	FILE *fp = fopen(infilename, "r");
+	if (fp == NULL) {
+		perror("open input file error");
+		return;
+	}
+	DATASET *a = import_dataset(fp);
+	rewind(fp);
+	DATASET *b = import_dataset_parallel(fp, 4);
+	fclose(fp);
+	if (a && b) {
+		printf("import_dataset_parallel():%d\n", b->count);
+		printf("same as import_dataset: %s\n", a->count == b->count
+				&& memcmp(a->records, b->records, a->count * sizeof *a->records) == 0 ? "yes" : "no");
+	}
+	dataset_free(a);
+	dataset_free(b);
+	printf("\n");
+}
+
+/*
+ * About 9 MB of records mixed with blank lines, garbage and lines longer than
+ * 256 bytes, without a final newline, so every thread gets a range and most
+ * range boundaries fall mid-line.
+ */
+void test_import_dataset_parallel_large() {
+	printf("------------------\n");
+	printf("Test: import_dataset_parallel, 9 MB of mixed lines\n\n");
+	FILE *fp = tmpfile();
+	if (fp == NULL) {
+		perror("open temp file error");
+		return;
+	}
+	char longname[400];
+	memset(longname, 'L', sizeof longname - 1);
+	longname[sizeof longname - 1] = '\0';
+	srand(21);
+	for (int i = 0; i < 600000; i++) {
+		int r = rand() % 100;
+		if (r == 0) fprintf(fp, "\n");
+		else if (r == 1) fprintf(fp, "garbage line %d\n", i);
+		else if (r == 2) fprintf(fp, ",%d\n", i % 100);
+		else if (r == 3) fprintf(fp, "%.*s,%d\n", 250 + rand() % 140, longname, i % 100);
+		else fprintf(fp, "S%d,%d.%d\n", i, rand() % 101, rand() % 10);
+	}
+	fprintf(fp, "last,42");
+	fflush(fp);
+	printf("file size: %ld bytes\n", ftell(fp));
+
+	rewind(fp);
+	DATASET *a = import_dataset(fp);
+	int threads[] = {1, 2, 3, 4, 8};
+	for (int t = 0; a && t < 5; t++) {
+		rewind(fp);
+		DATASET *b = import_dataset_parallel(fp, threads[t]);
+		printf("%d threads: %s\n", threads[t], b && a->count == b->count
+				&& memcmp(a->records, b->records, a->count * sizeof *a->records) == 0
+				? "same as import_dataset" : "DIFFERENT");
+		dataset_free(b);
+	}
+	if (a) printf("records: %d\n", a->count);
+	dataset_free(a);
+	fclose(fp);
+	printf("\n");
+}
+
+void test_recordset() {
+	printf("------------------\n");
+	printf("Test: recordset\n\n");
+	FILE *fp = fopen(infilename, "r");
+	if (fp == NULL) {
+		perror("open input file error");
+		return;
+	}
+	RECORDSET *rs = import_recordset(fp);
+	rewind(fp);
+	RECORD dataset[MAX_REC], back[MAX_REC];
+	memset(dataset, 0, sizeof dataset);
+	memset(back, 0, sizeof back);
+	int count = import_data(fp, dataset);
+	fclose(fp);
+	if (rs == NULL) {
+		printf("import_recordset(): out of memory\n");
+		return;
+	}
+	printf("import_recordset():%d\n", rs->count);
+	int n = recordset_to_records(rs, back);
+	printf("recordset_to_records same as import_data: %s\n",
+			n == count && memcmp(back, dataset, n * sizeof *back) == 0 ? "yes" : "no");
+
+	STATS stats = process_recordset(rs);
+	printf(stats_title);
+	printf(stats_format, "count", (float) stats.count);
+	printf(stats_format, "mean", stats.mean);
+	printf(stats_format, "stddev", stats.stddev);
+	printf(stats_format, "median", stats.median);
+
+	uint32_t perm[MAX_REC];
+	if (recordset_order(rs, 1, perm)) {
+		printf(data_title);
+		for (int i = 0; i < rs->count; i++)
+			printf(data_format, rs->names + rs->name_off[perm[i]], rs->scores[perm[i]]);
+	}
+	recordset_free(rs);
+	printf("\n");
+}
+
+void test_histogram() {
+	printf("------------------\n");
+	printf("Test: process_data_hist\n\n");
+	RECORD dataset[MAX_REC];
+	FILE *fp = fopen(infilename, "r");
+	if (fp == NULL) {
+		perror("open input file error");
+		return;
+	}
+	int count = import_data(fp, dataset);
+	fclose(fp);
+
+	HISTOGRAM hist;
+	histogram_init(&hist, NULL, 0, 100, 5);
+	STATS stats = process_data_hist(dataset, count, &hist);
+	STATS plain = process_data(dataset, count);
+	printf("same stats as process_data: %s\n\n",
+			memcmp(&stats, &plain, sizeof stats) == 0 ? "yes" : "no");
+	report_histogram(stdout, &hist);
+	printf("\n");
+}
+
 int main(int argc, char *args[]) {
 	test_grade();
+	test_grade_many();
 	test_import_data();
+	test_import_data_mmap();
+	test_import_scores();
 	test_process_data();
+	test_sort_records();
 	test_report_data();
+	test_histogram();
+	test_import_dataset();
+	test_import_dataset_parallel();
+	test_import_dataset_parallel_large();
+	test_recordset();
 	return 0;
 }
@@ -1,10 +1,28 @@
 /*
  * your program signature
  */ 
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <math.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NETWORK_X86 1
+#endif
 #include "mysort.h"
+#include "mysort_template.h"
+
+#ifdef MYSORT_STATS
+unsigned long long mysort_compares;
+unsigned long long mysort_swaps;
+#endif
 
 // swap pointers
 void swap(void **x, void **y) {
+     MYSORT_COUNT(mysort_swaps, 1);
      void *temp = *y;
      *y = *x;
      *x = temp;
@@ -12,6 +30,7 @@ void swap(void **x, void **y) {
 
 // a compare floating values pointed by void pointers. 
 int cmp(void *x, void *y) {
+   MYSORT_COUNT(mysort_compares, 1);
    float a = *(float*)x;
    float b = *(float*)y; 
      if (a > b) return 1;
@@ -40,9 +59,225 @@ void select_sort(void *a[], int left, int right){
     }
 }
 
+// comparison function carried through the template's ctx argument
+typedef struct {
+    int (*cmp)(void*, void*);
+} CMP_CTX;
+
+#define CMP_LESS(x, y, ctx) (((const CMP_CTX *)(ctx))->cmp((x), (y)) < 0)
+#define CMP_EQUAL(LESS, x, y, ctx) (((const CMP_CTX *)(ctx))->cmp((x), (y)) == 0)
+#define FLOAT_PTR_LESS(x, y, ctx) \
+    (MYSORT_COUNT(mysort_compares, 1), *(const float *)(x) < *(const float *)(y))
+#define FLOAT_LESS(x, y, ctx) (MYSORT_COUNT(mysort_compares, 1), (x) < (y))
+
+MYSORT_DEFINE_EQ(vp, void *, CMP_LESS, CMP_EQUAL, MYSORT_INSERTION_CUTOFF, vp_insertion_sort)
+
+
+
+#define NETWORK_MIN 8
+#define NETWORK_MAX 64
+#define NETWORK_BASE_N 64
+
+/*
+ * Bitonic sorting networks over up to 64 (key, index) pairs, used as the base
+ * case of the float introsorts. Keys are padded with +inf to a power of two
+ * p >= 8; the index travels with its key through every compare-exchange.
+ * Each stage (k, j) compares lane i with lane i^j, ascending when (i & k) == 0.
+ */
+typedef void (*NETWORK_KERNEL)(float *key, uint32_t *idx, int p);
+
+static void network_sort_scalar(float *key, uint32_t *idx, int p) {
+    for (int k = 2; k <= p; k <<= 1) {
+        for (int j = k >> 1; j > 0; j >>= 1) {
+            for (int i = 0; i < p; i++) {
+                int l = i ^ j;
+                if (l < i) continue;
+                int asc = (i & k) == 0;
+                if (asc ? key[l] < key[i] : key[i] < key[l]) {
+                    float tk = key[i]; key[i] = key[l]; key[l] = tk;
+                    uint32_t ti = idx[i]; idx[i] = idx[l]; idx[l] = ti;
+                }
+            }
+        }
+    }
+}
+
+#ifdef NETWORK_X86
+/*
+ * Vector compare-exchange. For j >= lane width the partner lanes sit in a
+ * second vector with the same direction for the whole vector. For smaller j
+ * the partner is a shuffle of the same vector; the lower lane of each pair
+ * keeps the min (max when descending), the upper one the max, and on ties both
+ * take the partner, so the pair stays a permutation.
+ */
+static __m128 sse2_select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static void network_sort_sse2(float *key, uint32_t *idx, int p) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+
+    for (int k = 2; k <= p; k <<= 1) {
+        for (int j = k >> 1; j > 0; j >>= 1) {
+            for (int b = 0; b < p; b += 4) {
+                if (j >= 4) {
+                    if (b & j) continue;
+                    __m128 ka = _mm_loadu_ps(key + b), kb = _mm_loadu_ps(key + b + j);
+                    __m128 ia = _mm_loadu_ps((float *)idx + b), ib = _mm_loadu_ps((float *)idx + b + j);
+                    __m128 keep = (b & k) ? _mm_cmpge_ps(ka, kb) : _mm_cmple_ps(ka, kb);
+                    _mm_storeu_ps(key + b, sse2_select(keep, ka, kb));
+                    _mm_storeu_ps(key + b + j, sse2_select(keep, kb, ka));
+                    _mm_storeu_ps((float *)idx + b, sse2_select(keep, ia, ib));
+                    _mm_storeu_ps((float *)idx + b + j, sse2_select(keep, ib, ia));
+                } else {
+                    __m128 kv = _mm_loadu_ps(key + b);
+                    __m128 iv = _mm_loadu_ps((float *)idx + b);
+                    __m128 kp, ip;
+                    if (j == 2) {
+                        kp = _mm_shuffle_ps(kv, kv, _MM_SHUFFLE(1, 0, 3, 2));
+                        ip = _mm_shuffle_ps(iv, iv, _MM_SHUFFLE(1, 0, 3, 2));
+                    } else {
+                        kp = _mm_shuffle_ps(kv, kv, _MM_SHUFFLE(2, 3, 0, 1));
+                        ip = _mm_shuffle_ps(iv, iv, _MM_SHUFFLE(2, 3, 0, 1));
+                    }
+                    __m128i lane = _mm_add_epi32(_mm_set1_epi32(b), lanes);
+                    __m128i lower = _mm_cmpeq_epi32(_mm_and_si128(lane, _mm_set1_epi32(j)), zero);
+                    __m128i asc = _mm_cmpeq_epi32(_mm_and_si128(lane, _mm_set1_epi32(k)), zero);
+                    __m128 want_min = _mm_castsi128_ps(_mm_xor_si128(_mm_xor_si128(lower, asc), ones));
+                    __m128 take = sse2_select(want_min, _mm_cmplt_ps(kv, kp), _mm_cmpgt_ps(kv, kp));
+                    _mm_storeu_ps(key + b, sse2_select(take, kv, kp));
+                    _mm_storeu_ps((float *)idx + b, sse2_select(take, iv, ip));
+                }
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static void network_sort_avx2(float *key, uint32_t *idx, int p) {
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (int k = 2; k <= p; k <<= 1) {
+        for (int j = k >> 1; j > 0; j >>= 1) {
+            for (int b = 0; b < p; b += 8) {
+                if (j >= 8) {
+                    if (b & j) continue;
+                    __m256 ka = _mm256_loadu_ps(key + b), kb = _mm256_loadu_ps(key + b + j);
+                    __m256 ia = _mm256_loadu_ps((float *)idx + b), ib = _mm256_loadu_ps((float *)idx + b + j);
+                    __m256 keep = (b & k) ? _mm256_cmp_ps(ka, kb, _CMP_GE_OQ)
+                                          : _mm256_cmp_ps(ka, kb, _CMP_LE_OQ);
+                    _mm256_storeu_ps(key + b, _mm256_blendv_ps(kb, ka, keep));
+                    _mm256_storeu_ps(key + b + j, _mm256_blendv_ps(ka, kb, keep));
+                    _mm256_storeu_ps((float *)idx + b, _mm256_blendv_ps(ib, ia, keep));
+                    _mm256_storeu_ps((float *)idx + b + j, _mm256_blendv_ps(ia, ib, keep));
+                } else {
+                    __m256 kv = _mm256_loadu_ps(key + b);
+                    __m256 iv = _mm256_loadu_ps((float *)idx + b);
+                    __m256 kp, ip;
+                    if (j == 4) {
+                        kp = _mm256_permute2f128_ps(kv, kv, 1);
+                        ip = _mm256_permute2f128_ps(iv, iv, 1);
+                    } else if (j == 2) {
+                        kp = _mm256_shuffle_ps(kv, kv, _MM_SHUFFLE(1, 0, 3, 2));
+                        ip = _mm256_shuffle_ps(iv, iv, _MM_SHUFFLE(1, 0, 3, 2));
+                    } else {
+                        kp = _mm256_shuffle_ps(kv, kv, _MM_SHUFFLE(2, 3, 0, 1));
+                        ip = _mm256_shuffle_ps(iv, iv, _MM_SHUFFLE(2, 3, 0, 1));
+                    }
+                    __m256i lane = _mm256_add_epi32(_mm256_set1_epi32(b), lanes);
+                    __m256i lower = _mm256_cmpeq_epi32(_mm256_and_si256(lane, _mm256_set1_epi32(j)), zero);
+                    __m256i asc = _mm256_cmpeq_epi32(_mm256_and_si256(lane, _mm256_set1_epi32(k)), zero);
+                    __m256 want_max = _mm256_castsi256_ps(_mm256_xor_si256(lower, asc));
+                    __m256 take = _mm256_blendv_ps(_mm256_cmp_ps(kv, kp, _CMP_LT_OQ),
+                                                   _mm256_cmp_ps(kv, kp, _CMP_GT_OQ), want_max);
+                    _mm256_storeu_ps(key + b, _mm256_blendv_ps(kp, kv, take));
+                    _mm256_storeu_ps((float *)idx + b, _mm256_blendv_ps(ip, iv, take));
+                }
+            }
+        }
+    }
+}
+#endif
+
+static NETWORK_KERNEL network_kernel = network_sort_scalar;
+static pthread_once_t network_once = PTHREAD_ONCE_INIT;
+
+// pick the widest kernel the running CPU supports
+static void network_init(void) {
+#ifdef NETWORK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        network_kernel = network_sort_avx2;
+    else if (__builtin_cpu_supports("sse2"))
+        network_kernel = network_sort_sse2;
+#endif
+}
+
+/*
+ * Sort n <= 64 keys with their indexes 0..n-1. Padding entries get index n and
+ * may only end up among the trailing +inf keys, so callers keep the first n
+ * entries that have an index below n.
+ */
+static int network_sort(float *key, uint32_t *idx, int n) {
+    int p = NETWORK_MIN;
+    while (p < n) p <<= 1;
+    for (int i = 0; i < n; i++) idx[i] = (uint32_t)i;
+    for (int i = n; i < p; i++) {
+        key[i] = INFINITY;
+        idx[i] = (uint32_t)n;
+    }
+    pthread_once(&network_once, network_init);
+    network_kernel(key, idx, p);
+#ifdef MYSORT_STATS
+    int stages = 0;
+    for (int k = 2; k <= p; k <<= 1)
+        for (int j = k >> 1; j > 0; j >>= 1) stages++;
+    MYSORT_COUNT(mysort_compares, (unsigned long long)stages * (p / 2));
+#endif
+    return p;
+}
+
+// base case of quick_sort: sort pointers to floats through the network
+static void fp_network_sort(void **a, int left, int right, const void *ctx) {
+    float key[NETWORK_MAX];
+    uint32_t idx[NETWORK_MAX];
+    void *tmp[NETWORK_MAX];
+    int n = right - left + 1;
+    if (n < 2) return;
+
+    for (int i = 0; i < n; i++) key[i] = *(const float *)a[left + i];
+    int p = network_sort(key, idx, n);
+    for (int i = 0, m = 0; i < p && m < n; i++)
+        if (idx[i] < (uint32_t)n) tmp[m++] = a[left + idx[i]];
+    memcpy(a + left, tmp, n * sizeof *tmp);
+}
+
+// base case of float_sort; a NaN key can land among or after the +inf
+// padding, so the keys are written back by index like fp_network_sort
+static void flt_network_sort(float *a, int left, int right, const void *ctx) {
+    float key[NETWORK_MAX];
+    uint32_t idx[NETWORK_MAX];
+    int n = right - left + 1;
+    if (n < 2) return;
+
+    memcpy(key, a + left, n * sizeof *key);
+    int p = network_sort(key, idx, n);
+    for (int i = 0, m = 0; i < p && m < n; i++)
+        if (idx[i] < (uint32_t)n) a[left + m++] = key[i];
+}
+
+MYSORT_DEFINE_EX(fp, void *, FLOAT_PTR_LESS, NETWORK_BASE_N, fp_network_sort)
+MYSORT_DEFINE_EX(flt, float, FLOAT_LESS, NETWORK_BASE_N, flt_network_sort)
+
 /**
  * Use quick sort algorithm to sort array of pointers such that their pointed values 
- * are in increasing order.
+ * are in increasing order. Runs as introsort: ninther/median-of-three pivot,
+ * ranges of at most 64 elements finished by a bitonic sorting network
+ * (SSE2 or AVX2 when the CPU has it, scalar otherwise) and heap sort once the
+ * recursion depth exceeds 2*log2(n), so the worst case is O(n log n).
  *
  * @param *a[] - array of void pointers. 
  * @param left - the start index of pointer in array.
@@ -50,47 +285,972 @@ void select_sort(void *a[], int left, int right){
  */
 void quick_sort(void *a[], int left, int right){
     if (!a || left >= right) return;
+    fp_sort(a + left, right - left + 1, NULL);
+}
+
+
+
+/**
+ * Use either selection or quick sort algorithm to sort array of pointers such that their pointed values 
+ * are in order defined by the given comparison function. Uses the same
+ * introsort engine as quick_sort.
+ *
+ * @param *a[] - array of void pointers. 
+ * @param left - the start index of pointer in array.
+ * @param right - the end index of pointer in array
+ * @param (*cmp) - pointer to a comparison function used to compaire pointers by their pointed values.
+ */
+void my_sort(void *a[], int left, int right, int (*cmp)(void*, void*) ){
+    if (!a || left >= right || !cmp) return;
+    CMP_CTX ctx = {cmp};
+    vp_sort(a + left, right - left + 1, &ctx);
+}
+
+
+/**
+ * Sort an array of floats in place into increasing order with the introsort
+ * engine, comparing the values inline; as in quick_sort, ranges of at most 64
+ * elements are finished by the bitonic sorting network.
+ *
+ * @param a[] - array of floats.
+ * @param n - number of floats in array.
+ */
+void float_sort(float a[], int n) {
+    flt_sort(a, n, NULL);
+}
 
-    int i = left + 1;
-    int j = right;
 
-    while (i <= j) {
-        while (i <= right && cmp(a[i], a[left]) <= 0) i++;
-        while (j >= left && cmp(a[j], a[left]) > 0)  j--;
-        if (i < j) {
-            swap(&a[i], &a[j]);
+/**
+ * Rearrange array of pointers so that a[k] holds the pointer that would be at
+ * index k if a[left..right] were sorted by the given comparison function, with
+ * no greater element before it and no smaller element after it
+ * (introselect: quickselect with ninther pivots, falling back to heap sort of
+ * the remaining range if partitioning keeps going badly). Expected O(n).
+ *
+ * @param *a[] - array of void pointers.
+ * @param left - the start index of pointer in array.
+ * @param right - the end index of pointer in array
+ * @param k - the index to select, left <= k <= right.
+ * @param (*cmp) - pointer to a comparison function used to compaire pointers by their pointed values.
+ */
+void my_select(void *a[], int left, int right, int k, int (*cmp)(void*, void*)) {
+    if (!a || left >= right || !cmp || k < left || k > right) return;
+    CMP_CTX ctx = {cmp};
+    vp_select(a, left, right, k, &ctx);
+}
+
+/**
+ * Partially sort array of pointers so that a[left..left+k-1] holds the k
+ * smallest elements by the given comparison function, in order. The rest of
+ * the range is left in unspecified order. Uses a bounded max-heap, O(n log k).
+ *
+ * @param *a[] - array of void pointers.
+ * @param left - the start index of pointer in array.
+ * @param right - the end index of pointer in array
+ * @param k - number of leading elements to sort.
+ * @param (*cmp) - pointer to a comparison function used to compaire pointers by their pointed values.
+ */
+void my_partial_sort(void *a[], int left, int right, int k, int (*cmp)(void*, void*)) {
+    if (!a || left > right || !cmp || k <= 0) return;
+    CMP_CTX ctx = {cmp};
+    vp_partial_sort(a, left, right, k, &ctx);
+}
+
+/**
+ * Rearrange an array of floats so that a[k] holds the k-th smallest value, as
+ * my_select does for pointers.
+ *
+ * @param a[] - array of floats.
+ * @param n - number of floats in array.
+ * @param k - the index to select, 0 <= k < n.
+ */
+void float_select(float a[], int n, int k) {
+    if (!a || k < 0 || k >= n) return;
+    flt_select(a, 0, n - 1, k, NULL);
+}
+
+
+/**
+ * Sort array of pointers in the order defined by the given comparison function,
+ * using three-way (Bentley-McIlroy) partitioning. Preferable to my_sort when
+ * the keys have few distinct values, e.g. integer or half-point scores: each
+ * distinct key is settled by one partition step, so k distinct keys sort in
+ * O(n log k) comparisons.
+ *
+ * @param *a[] - array of void pointers.
+ * @param left - the start index of pointer in array.
+ * @param right - the end index of pointer in array
+ * @param (*cmp) - pointer to a comparison function used to compaire pointers by their pointed values.
+ */
+void my_sort_3way(void *a[], int left, int right, int (*cmp)(void*, void*) ){
+    if (!a || left >= right || !cmp) return;
+    CMP_CTX ctx = {cmp};
+    vp_sort3(a + left, right - left + 1, &ctx);
+}
+
+
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
+#define RADIX_PASSES 3
+
+/*
+ * Map a float to an unsigned key with the same order: flip all bits of
+ * negatives, and only the sign bit of non-negatives.
+ */
+static uint32_t float_key(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof u);
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+/*
+ * LSD radix sort of a[left..right] by the float found key_offset bytes into
+ * each pointed object. Keys are XORed with flip (0 for increasing, all ones for
+ * decreasing order). One pass builds all three 11-bit digit histograms, then
+ * each digit is scattered once; passes where every key shares the digit are
+ * skipped. Stable. Returns 1 on success, 0 if scratch memory is unavailable.
+ */
+static int radix_sort_key(void *a[], int left, int right, size_t key_offset, uint32_t flip) {
+    size_t n = (size_t)(right - left + 1);
+    uint32_t *keys = malloc(2 * n * sizeof *keys);
+    void **tmp = malloc(n * sizeof *tmp);
+    if (!keys || !tmp) {
+        free(keys);
+        free(tmp);
+        return 0;
+    }
+
+    static const int shift[RADIX_PASSES] = {0, RADIX_BITS, 2 * RADIX_BITS};
+    size_t (*hist)[RADIX_SIZE] = calloc(RADIX_PASSES, sizeof *hist);
+    if (!hist) {
+        free(keys);
+        free(tmp);
+        return 0;
+    }
+
+    void **src = a + left, **dst = tmp;
+    uint32_t *ksrc = keys, *kdst = keys + n;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t k = float_key(*(float *)((char *)src[i] + key_offset)) ^ flip;
+        ksrc[i] = k;
+        hist[0][k & RADIX_MASK]++;
+        hist[1][(k >> shift[1]) & RADIX_MASK]++;
+        hist[2][k >> shift[2]]++;
+    }
+
+    for (int p = 0; p < RADIX_PASSES; p++) {
+        size_t *h = hist[p];
+        if (h[(ksrc[0] >> shift[p]) & RADIX_MASK] == n) continue;
+
+        size_t sum = 0;
+        for (int d = 0; d < RADIX_SIZE; d++) {
+            size_t c = h[d];
+            h[d] = sum;
+            sum += c;
         }
+        for (size_t i = 0; i < n; i++) {
+            uint32_t k = ksrc[i];
+            size_t pos = h[(k >> shift[p]) & RADIX_MASK]++;
+            kdst[pos] = k;
+            dst[pos] = src[i];
+        }
+
+        void **t = src; src = dst; dst = t;
+        uint32_t *kt = ksrc; ksrc = kdst; kdst = kt;
     }
-    swap(&a[left], &a[j]);
 
-    if (left < j - 1)  quick_sort(a, left, j - 1);
-    if (j + 1 < right) quick_sort(a, j + 1, right);
+    if (src != a + left)
+        memcpy(a + left, src, n * sizeof *src);
+
+    free(hist);
+    free(keys);
+    free(tmp);
+    return 1;
 }
 
+/**
+ * Use LSD radix sort to sort array of pointers such that the float keys they
+ * point to are in increasing order, without a comparison function. The key of
+ * a[i] is the float at byte offset key_offset in the pointed object: 0 for
+ * pointers to float, offsetof(RECORD, score) for pointers to RECORD.
+ * Stable; equal keys keep their original order.
+ *
+ * @param *a[] - array of void pointers.
+ * @param left - the start index of pointer in array.
+ * @param right - the end index of pointer in array
+ * @param key_offset - byte offset of the float key in each pointed object.
+ * @return - 1 if sorted, 0 if scratch memory could not be allocated.
+ */
+int radix_sort(void *a[], int left, int right, size_t key_offset) {
+    if (!a || left >= right) return 1;
+    return radix_sort_key(a, left, right, key_offset, 0);
+}
 
+/**
+ * Same as radix_sort, but sorts the float keys into decreasing order.
+ * Stable; equal keys keep their original order.
+ *
+ * @param *a[] - array of void pointers.
+ * @param left - the start index of pointer in array.
+ * @param right - the end index of pointer in array
+ * @param key_offset - byte offset of the float key in each pointed object.
+ * @return - 1 if sorted, 0 if scratch memory could not be allocated.
+ */
+int radix_sort_desc(void *a[], int left, int right, size_t key_offset) {
+    if (!a || left >= right) return 1;
+    return radix_sort_key(a, left, right, key_offset, 0xFFFFFFFFu);
+}
+
+
+/*
+ * LSD radix sort of key/index pairs by key, with the same digit layout as
+ * radix_sort_key. The pairs themselves are scattered, so every pass streams
+ * through two contiguous 8-byte-per-element buffers and never touches the
+ * records the indexes refer to.
+ */
+static int pair_radix_sort(KEYPAIR p[], int n, uint32_t flip) {
+    KEYPAIR *tmp = malloc((size_t)n * sizeof *tmp);
+    size_t (*hist)[RADIX_SIZE] = calloc(RADIX_PASSES, sizeof *hist);
+    if (!tmp || !hist) {
+        free(tmp);
+        free(hist);
+        return 0;
+    }
+
+    static const int shift[RADIX_PASSES] = {0, RADIX_BITS, 2 * RADIX_BITS};
+    for (int i = 0; i < n; i++) {
+        uint32_t k = float_key(p[i].key) ^ flip;
+        hist[0][k & RADIX_MASK]++;
+        hist[1][(k >> shift[1]) & RADIX_MASK]++;
+        hist[2][k >> shift[2]]++;
+    }
+
+    KEYPAIR *src = p, *dst = tmp;
+    for (int d = 0; d < RADIX_PASSES; d++) {
+        size_t *h = hist[d];
+        if (h[((float_key(src[0].key) ^ flip) >> shift[d]) & RADIX_MASK] == (size_t)n) continue;
+
+        size_t sum = 0;
+        for (int b = 0; b < RADIX_SIZE; b++) {
+            size_t c = h[b];
+            h[b] = sum;
+            sum += c;
+        }
+        for (int i = 0; i < n; i++) {
+            uint32_t k = float_key(src[i].key) ^ flip;
+            dst[h[(k >> shift[d]) & RADIX_MASK]++] = src[i];
+        }
+
+        KEYPAIR *t = src; src = dst; dst = t;
+    }
+
+    if (src != p)
+        memcpy(p, src, (size_t)n * sizeof *p);
+
+    free(hist);
+    free(tmp);
+    return 1;
+}
 
 /**
- * Use either selection or quick sort algorithm to sort array of pointers such that their pointed values 
- * are in order defined by the given comparison function
+ * Sort a contiguous array of (key, index) pairs into increasing key order.
+ * Sorting compact pairs instead of pointers keeps every access sequential;
+ * the index field then gives the permutation of the original objects.
+ * Stable; equal keys keep their original order.
  *
- * @param *a[] - array of void pointers. 
+ * @param p[] - array of key/index pairs.
+ * @param n - number of pairs.
+ * @return - 1 if sorted, 0 if scratch memory could not be allocated.
+ */
+int pair_sort(KEYPAIR p[], int n) {
+    if (!p || n < 2) return 1;
+    return pair_radix_sort(p, n, 0);
+}
+
+/**
+ * Same as pair_sort, but sorts the pairs into decreasing key order.
+ *
+ * @param p[] - array of key/index pairs.
+ * @param n - number of pairs.
+ * @return - 1 if sorted, 0 if scratch memory could not be allocated.
+ */
+int pair_sort_desc(KEYPAIR p[], int n) {
+    if (!p || n < 2) return 1;
+    return pair_radix_sort(p, n, 0xFFFFFFFFu);
+}
+
+
+#define MIN_MERGE 64
+#define MIN_GALLOP 7
+#define MAX_RUNS 85
+
+// pending runs and galloping state of one tim_sort call
+typedef struct {
+    void **a;
+    int (*cmp)(void*, void*);
+    SORT_BUFFER *buf;
+    int min_gallop;
+    int nruns;
+    int run_base[MAX_RUNS];
+    int run_len[MAX_RUNS];
+} MERGE_STATE;
+
+// make room for need pointers in the scratch buffer, growing it geometrically
+static int buffer_reserve(SORT_BUFFER *b, int need) {
+    if (b->cap >= need) return 1;
+    int cap = b->cap * 2 > need ? b->cap * 2 : need;
+    void **p = realloc(b->buf, cap * sizeof *p);
+    if (!p) return 0;
+    b->buf = p;
+    b->cap = cap;
+    return 1;
+}
+
+// a[lo..start) is sorted; insert a[start..hi) into it, placing equal keys after
+static void binary_insertion_sort(void **a, int lo, int hi, int start, int (*cmp)(void*, void*)) {
+    for (; start < hi; start++) {
+        void *pivot = a[start];
+        int l = lo, r = start;
+        while (l < r) {
+            int mid = (l + r) >> 1;
+            if (cmp(pivot, a[mid]) < 0) r = mid;
+            else l = mid + 1;
+        }
+        memmove(&a[l + 1], &a[l], (start - l) * sizeof *a);
+        a[l] = pivot;
+    }
+}
+
+/*
+ * Length of the run starting at a[lo], at most up to hi (exclusive). A strictly
+ * descending run is reversed in place; strictness keeps the sort stable.
+ */
+static int count_run(void **a, int lo, int hi, int (*cmp)(void*, void*)) {
+    int run_hi = lo + 1;
+    if (run_hi == hi) return 1;
+    if (cmp(a[run_hi++], a[lo]) < 0) {
+        while (run_hi < hi && cmp(a[run_hi], a[run_hi - 1]) < 0) run_hi++;
+        for (int i = lo, j = run_hi - 1; i < j; i++, j--) swap(&a[i], &a[j]);
+    } else {
+        while (run_hi < hi && cmp(a[run_hi], a[run_hi - 1]) >= 0) run_hi++;
+    }
+    return run_hi - lo;
+}
+
+// minimum run length for n elements: in [32, 64], so n / minrun is a power of two or just below
+static int min_run_length(int n) {
+    int r = 0;
+    while (n >= MIN_MERGE) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+/*
+ * Position to insert key into sorted a[base..base+len) before any equal
+ * element, searching outwards from base+hint in steps 1, 3, 7, ... and then
+ * by binary search.
+ */
+static int gallop_left(void *key, void **a, int base, int len, int hint, int (*cmp)(void*, void*)) {
+    int last = 0, ofs = 1;
+    if (cmp(key, a[base + hint]) > 0) {
+        int max = len - hint;
+        while (ofs < max && cmp(key, a[base + hint + ofs]) > 0) {
+            last = ofs;
+            ofs = (ofs << 1) + 1;
+            if (ofs <= 0) ofs = max;
+        }
+        if (ofs > max) ofs = max;
+        last += hint;
+        ofs += hint;
+    } else {
+        int max = hint + 1;
+        while (ofs < max && cmp(key, a[base + hint - ofs]) <= 0) {
+            last = ofs;
+            ofs = (ofs << 1) + 1;
+            if (ofs <= 0) ofs = max;
+        }
+        if (ofs > max) ofs = max;
+        int t = last;
+        last = hint - ofs;
+        ofs = hint - t;
+    }
+    last++;
+    while (last < ofs) {
+        int m = last + ((ofs - last) >> 1);
+        if (cmp(key, a[base + m]) > 0) last = m + 1;
+        else ofs = m;
+    }
+    return ofs;
+}
+
+// as gallop_left, but the position after any element equal to key
+static int gallop_right(void *key, void **a, int base, int len, int hint, int (*cmp)(void*, void*)) {
+    int last = 0, ofs = 1;
+    if (cmp(key, a[base + hint]) < 0) {
+        int max = hint + 1;
+        while (ofs < max && cmp(key, a[base + hint - ofs]) < 0) {
+            last = ofs;
+            ofs = (ofs << 1) + 1;
+            if (ofs <= 0) ofs = max;
+        }
+        if (ofs > max) ofs = max;
+        int t = last;
+        last = hint - ofs;
+        ofs = hint - t;
+    } else {
+        int max = len - hint;
+        while (ofs < max && cmp(key, a[base + hint + ofs]) >= 0) {
+            last = ofs;
+            ofs = (ofs << 1) + 1;
+            if (ofs <= 0) ofs = max;
+        }
+        if (ofs > max) ofs = max;
+        last += hint;
+        ofs += hint;
+    }
+    last++;
+    while (last < ofs) {
+        int m = last + ((ofs - last) >> 1);
+        if (cmp(key, a[base + m]) < 0) ofs = m;
+        else last = m + 1;
+    }
+    return ofs;
+}
+
+/*
+ * Merge adjacent runs a[base1..+len1) and a[base2..+len2) with len1 <= len2,
+ * copying the first run to the scratch buffer and filling from the left.
+ * After min_gallop consecutive wins by one run the merge switches to
+ * galloping, copying whole blocks found by exponential search.
+ */
+static int merge_lo(MERGE_STATE *ms, int base1, int len1, int base2, int len2) {
+    if (!buffer_reserve(ms->buf, len1)) return 0;
+    void **a = ms->a, **tmp = ms->buf->buf;
+    int (*cmp)(void*, void*) = ms->cmp;
+    memcpy(tmp, a + base1, len1 * sizeof *a);
+
+    int c1 = 0, c2 = base2, dest = base1;
+    a[dest++] = a[c2++];
+    if (--len2 == 0) {
+        memcpy(a + dest, tmp + c1, len1 * sizeof *a);
+        return 1;
+    }
+    if (len1 == 1) {
+        memmove(a + dest, a + c2, len2 * sizeof *a);
+        a[dest + len2] = tmp[c1];
+        return 1;
+    }
+
+    int min_gallop = ms->min_gallop;
+    for (;;) {
+        int count1 = 0, count2 = 0;
+        do {
+            if (cmp(a[c2], tmp[c1]) < 0) {
+                a[dest++] = a[c2++];
+                count2++;
+                count1 = 0;
+                if (--len2 == 0) goto done;
+            } else {
+                a[dest++] = tmp[c1++];
+                count1++;
+                count2 = 0;
+                if (--len1 == 1) goto done;
+            }
+        } while ((count1 | count2) < min_gallop);
+
+        do {
+            count1 = gallop_right(a[c2], tmp, c1, len1, 0, cmp);
+            if (count1) {
+                memcpy(a + dest, tmp + c1, count1 * sizeof *a);
+                dest += count1;
+                c1 += count1;
+                len1 -= count1;
+                if (len1 <= 1) goto done;
+            }
+            a[dest++] = a[c2++];
+            if (--len2 == 0) goto done;
+
+            count2 = gallop_left(tmp[c1], a, c2, len2, 0, cmp);
+            if (count2) {
+                memmove(a + dest, a + c2, count2 * sizeof *a);
+                dest += count2;
+                c2 += count2;
+                len2 -= count2;
+                if (len2 == 0) goto done;
+            }
+            a[dest++] = tmp[c1++];
+            if (--len1 == 1) goto done;
+            min_gallop--;
+        } while (count1 >= MIN_GALLOP || count2 >= MIN_GALLOP);
+        if (min_gallop < 0) min_gallop = 0;
+        min_gallop += 2;
+    }
+
+done:
+    ms->min_gallop = min_gallop < 1 ? 1 : min_gallop;
+    if (len1 == 1) {
+        memmove(a + dest, a + c2, len2 * sizeof *a);
+        a[dest + len2] = tmp[c1];
+    } else if (len1 > 0) {
+        memcpy(a + dest, tmp + c1, len1 * sizeof *a);
+    }
+    return 1;
+}
+
+// mirror of merge_lo for len1 > len2: buffers the second run and fills from the right
+static int merge_hi(MERGE_STATE *ms, int base1, int len1, int base2, int len2) {
+    if (!buffer_reserve(ms->buf, len2)) return 0;
+    void **a = ms->a, **tmp = ms->buf->buf;
+    int (*cmp)(void*, void*) = ms->cmp;
+    memcpy(tmp, a + base2, len2 * sizeof *a);
+
+    int c1 = base1 + len1 - 1, c2 = len2 - 1, dest = base2 + len2 - 1;
+    a[dest--] = a[c1--];
+    if (--len1 == 0) {
+        memcpy(a + dest - (len2 - 1), tmp, len2 * sizeof *a);
+        return 1;
+    }
+    if (len2 == 1) {
+        dest -= len1;
+        c1 -= len1;
+        memmove(a + dest + 1, a + c1 + 1, len1 * sizeof *a);
+        a[dest] = tmp[c2];
+        return 1;
+    }
+
+    int min_gallop = ms->min_gallop;
+    for (;;) {
+        int count1 = 0, count2 = 0;
+        do {
+            if (cmp(tmp[c2], a[c1]) < 0) {
+                a[dest--] = a[c1--];
+                count1++;
+                count2 = 0;
+                if (--len1 == 0) goto done;
+            } else {
+                a[dest--] = tmp[c2--];
+                count2++;
+                count1 = 0;
+                if (--len2 == 1) goto done;
+            }
+        } while ((count1 | count2) < min_gallop);
+
+        do {
+            count1 = len1 - gallop_right(tmp[c2], a, base1, len1, len1 - 1, cmp);
+            if (count1) {
+                dest -= count1;
+                c1 -= count1;
+                len1 -= count1;
+                memmove(a + dest + 1, a + c1 + 1, count1 * sizeof *a);
+                if (len1 == 0) goto done;
+            }
+            a[dest--] = tmp[c2--];
+            if (--len2 == 1) goto done;
+
+            count2 = len2 - gallop_left(a[c1], tmp, 0, len2, len2 - 1, cmp);
+            if (count2) {
+                dest -= count2;
+                c2 -= count2;
+                len2 -= count2;
+                memcpy(a + dest + 1, tmp + c2 + 1, count2 * sizeof *a);
+                if (len2 <= 1) goto done;
+            }
+            a[dest--] = a[c1--];
+            if (--len1 == 0) goto done;
+            min_gallop--;
+        } while (count1 >= MIN_GALLOP || count2 >= MIN_GALLOP);
+        if (min_gallop < 0) min_gallop = 0;
+        min_gallop += 2;
+    }
+
+done:
+    ms->min_gallop = min_gallop < 1 ? 1 : min_gallop;
+    if (len2 == 1) {
+        dest -= len1;
+        c1 -= len1;
+        memmove(a + dest + 1, a + c1 + 1, len1 * sizeof *a);
+        a[dest] = tmp[c2];
+    } else if (len2 > 0) {
+        memcpy(a + dest - (len2 - 1), tmp, len2 * sizeof *a);
+    }
+    return 1;
+}
+
+// merge pending runs i and i+1
+static int merge_at(MERGE_STATE *ms, int i) {
+    int base1 = ms->run_base[i], len1 = ms->run_len[i];
+    int base2 = ms->run_base[i + 1], len2 = ms->run_len[i + 1];
+
+    ms->run_len[i] = len1 + len2;
+    if (i == ms->nruns - 3) {
+        ms->run_base[i + 1] = ms->run_base[i + 2];
+        ms->run_len[i + 1] = ms->run_len[i + 2];
+    }
+    ms->nruns--;
+
+    // skip the elements of run 1 already in place, and of run 2 past the end of run 1
+    int k = gallop_right(ms->a[base2], ms->a, base1, len1, 0, ms->cmp);
+    base1 += k;
+    len1 -= k;
+    if (len1 == 0) return 1;
+    len2 = gallop_left(ms->a[base1 + len1 - 1], ms->a, base2, len2, len2 - 1, ms->cmp);
+    if (len2 == 0) return 1;
+
+    return len1 <= len2 ? merge_lo(ms, base1, len1, base2, len2)
+                        : merge_hi(ms, base1, len1, base2, len2);
+}
+
+// merge until the run lengths on the stack shrink faster than the Fibonacci numbers
+static int merge_collapse(MERGE_STATE *ms) {
+    int *len = ms->run_len;
+    while (ms->nruns > 1) {
+        int n = ms->nruns - 2;
+        if ((n > 0 && len[n - 1] <= len[n] + len[n + 1]) ||
+            (n > 1 && len[n - 2] <= len[n - 1] + len[n])) {
+            if (len[n - 1] < len[n + 1]) n--;
+        } else if (len[n] > len[n + 1]) {
+            break;
+        }
+        if (!merge_at(ms, n)) return 0;
+    }
+    return 1;
+}
+
+static int merge_force_collapse(MERGE_STATE *ms) {
+    while (ms->nruns > 1) {
+        int n = ms->nruns - 2;
+        if (n > 0 && ms->run_len[n - 1] < ms->run_len[n + 1]) n--;
+        if (!merge_at(ms, n)) return 0;
+    }
+    return 1;
+}
+
+/**
+ * Use a stable natural merge sort (Timsort) to sort array of pointers in the
+ * order defined by the given comparison function. Existing ascending and
+ * strictly descending runs are detected and kept, short runs are extended
+ * with binary insertion sort, and runs are merged with galloping, so
+ * presorted input takes about n comparisons. Equal elements keep their
+ * original order.
+ *
+ * @param *a[] - array of void pointers.
  * @param left - the start index of pointer in array.
  * @param right - the end index of pointer in array
  * @param (*cmp) - pointer to a comparison function used to compaire pointers by their pointed values.
+ * @param *buf - scratch buffer reused across calls, or NULL for a temporary one.
+ * @return - 1 if sorted, 0 if scratch memory could not be allocated.
  */
-void my_sort(void *a[], int left, int right, int (*cmp)(void*, void*) ){
+int tim_sort(void *a[], int left, int right, int (*cmp)(void*, void*), SORT_BUFFER *buf) {
+    if (!a || !cmp) return 0;
+    if (left >= right) return 1;
+
+    int lo = left, hi = right + 1, n = hi - lo;
+    if (n < MIN_MERGE) {
+        int run = count_run(a, lo, hi, cmp);
+        binary_insertion_sort(a, lo, hi, lo + run, cmp);
+        return 1;
+    }
+
+    SORT_BUFFER local = {NULL, 0};
+    MERGE_STATE ms;
+    ms.a = a;
+    ms.cmp = cmp;
+    ms.buf = buf ? buf : &local;
+    ms.min_gallop = MIN_GALLOP;
+    ms.nruns = 0;
+
+    int min_run = min_run_length(n);
+    int ok = 1;
+    while (n > 0 && ok) {
+        int run = count_run(a, lo, hi, cmp);
+        if (run < min_run) {
+            int force = n <= min_run ? n : min_run;
+            binary_insertion_sort(a, lo, lo + force, lo + run, cmp);
+            run = force;
+        }
+        ms.run_base[ms.nruns] = lo;
+        ms.run_len[ms.nruns] = run;
+        ms.nruns++;
+        ok = merge_collapse(&ms);
+        lo += run;
+        n -= run;
+    }
+    if (ok) ok = merge_force_collapse(&ms);
+
+    sort_buffer_free(&local);
+    return ok;
+}
+
+/**
+ * Release the memory held by a tim_sort scratch buffer.
+ *
+ * @param *buf - scratch buffer.
+ */
+void sort_buffer_free(SORT_BUFFER *buf) {
+    if (!buf) return;
+    free(buf->buf);
+    buf->buf = NULL;
+    buf->cap = 0;
+}
+
+
+
+#define PARALLEL_CUTOFF 8192
+#define STEAL_MAX 32
+
+// a sub-range of the array still to be sorted
+typedef struct {
+    int left, right, depth;
+} SORT_TASK;
+
+/*
+ * Per-worker task deque. The owner pushes and pops at the tail (LIFO, cache
+ * hot); thieves take the oldest, largest tasks from the head.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    SORT_TASK *tasks;
+    int head, tail, cap;
+} TASK_DEQUE;
+
+/*
+ * Workers that find every deque empty sleep on idle rather than spin. Each
+ * push and the final pool_done bump epoch and, if anyone sleeps, wake them:
+ * one sleeper per pushed task, everyone when the sort is done.
+ * A worker reads epoch before scanning the deques and only waits while it
+ * is unchanged, so work pushed after its scan always wakes it; epoch and
+ * sleepers are seq_cst so the pusher and the sleeper see at least one of
+ * each other's updates.
+ */
+typedef struct {
+    void **a;
+    CMP_CTX ctx;
+    int nworkers;
+    TASK_DEQUE *deques;
+    long pending;  // elements not yet in their final place
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle;
+    unsigned long epoch;
+    int sleepers;
+} SORT_POOL;
+
+typedef struct {
+    SORT_POOL *pool;
+    int id;
+} SORT_WORKER;
+
+static int deque_push(TASK_DEQUE *q, const SORT_TASK *t, int count) {
+    pthread_mutex_lock(&q->lock);
+    if (q->head == q->tail) q->head = q->tail = 0;
+    if (q->tail + count > q->cap) {
+        int live = q->tail - q->head;
+        memmove(q->tasks, q->tasks + q->head, live * sizeof *q->tasks);
+        q->head = 0;
+        q->tail = live;
+        if (live + count > q->cap) {
+            int cap = 2 * (live + count);
+            SORT_TASK *p = realloc(q->tasks, cap * sizeof *p);
+            if (!p) {
+                pthread_mutex_unlock(&q->lock);
+                return 0;
+            }
+            q->tasks = p;
+            q->cap = cap;
+        }
+    }
+    memcpy(q->tasks + q->tail, t, count * sizeof *t);
+    q->tail += count;
+    pthread_mutex_unlock(&q->lock);
+    return 1;
+}
+
+static int deque_pop(TASK_DEQUE *q, SORT_TASK *t) {
+    int ok = 0;
+    pthread_mutex_lock(&q->lock);
+    if (q->tail > q->head) {
+        *t = q->tasks[--q->tail];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+// take up to half of the victim's tasks from its head
+static int deque_steal_half(TASK_DEQUE *q, SORT_TASK *t) {
+    int count = 0;
+    pthread_mutex_lock(&q->lock);
+    int live = q->tail - q->head;
+    if (live > 0) {
+        count = (live + 1) / 2;
+        if (count > STEAL_MAX) count = STEAL_MAX;
+        memcpy(t, q->tasks + q->head, count * sizeof *t);
+        q->head += count;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return count;
+}
+
+// wake up to count sleeping workers, count <= 0 for all
+static void pool_wake(SORT_POOL *pool, int count) {
+    __atomic_add_fetch(&pool->epoch, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pool->idle_lock);
+        if (count <= 0 || count >= pool->sleepers)
+            pthread_cond_broadcast(&pool->idle);
+        else
+            while (count--) pthread_cond_signal(&pool->idle);
+        pthread_mutex_unlock(&pool->idle_lock);
+    }
+}
+
+// sleep until work is pushed after epoch was read, or the sort is done
+static void pool_wait(SORT_POOL *pool, unsigned long epoch) {
+    pthread_mutex_lock(&pool->idle_lock);
+    __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&pool->epoch, __ATOMIC_SEQ_CST) == epoch
+           && __atomic_load_n(&pool->pending, __ATOMIC_ACQUIRE) > 0)
+        pthread_cond_wait(&pool->idle, &pool->idle_lock);
+    __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&pool->idle_lock);
+}
+
+static int pool_push(SORT_POOL *pool, int id, const SORT_TASK *t, int count) {
+    if (!deque_push(&pool->deques[id], t, count)) return 0;
+    pool_wake(pool, count);
+    return 1;
+}
+
+static void pool_done(SORT_POOL *pool, long count) {
+    if (__atomic_sub_fetch(&pool->pending, count, __ATOMIC_SEQ_CST) == 0)
+        pool_wake(pool, 0);
+}
+
+/*
+ * Partition a task on this worker, pushing the larger side for others to steal
+ * and continuing with the smaller, until the range falls under the cutoff.
+ */
+static void run_task(SORT_POOL *pool, int id, SORT_TASK t) {
+    void **a = pool->a;
+    while (t.right - t.left + 1 > PARALLEL_CUTOFF) {
+        if (t.depth-- == 0) {
+            vp_heap_sort(a, t.left, t.right, &pool->ctx);
+            pool_done(pool, t.right - t.left + 1);
+            return;
+        }
+        int p = vp_partition(a, t.left, t.right, &pool->ctx);
+        pool_done(pool, 1);
+
+        SORT_TASK lo = {t.left, p - 1, t.depth};
+        SORT_TASK hi = {p + 1, t.right, t.depth};
+        SORT_TASK big = (p - t.left > t.right - p) ? lo : hi;
+        t = (p - t.left > t.right - p) ? hi : lo;
+        if (big.right - big.left + 1 <= PARALLEL_CUTOFF || !pool_push(pool, id, &big, 1)) {
+            vp_intro_sort(a, big.left, big.right, big.depth, &pool->ctx);
+            pool_done(pool, big.right - big.left + 1);
+        }
+    }
+    if (t.left <= t.right) {
+        vp_intro_sort(a, t.left, t.right, t.depth, &pool->ctx);
+        pool_done(pool, t.right - t.left + 1);
+    }
+}
+
+static void *sort_worker(void *arg) {
+    SORT_WORKER *w = arg;
+    SORT_POOL *pool = w->pool;
+    SORT_TASK stolen[STEAL_MAX];
+    SORT_TASK t;
+
+    while (__atomic_load_n(&pool->pending, __ATOMIC_ACQUIRE) > 0) {
+        unsigned long epoch = __atomic_load_n(&pool->epoch, __ATOMIC_SEQ_CST);
+        if (deque_pop(&pool->deques[w->id], &t)) {
+            run_task(pool, w->id, t);
+            continue;
+        }
+        int got = 0;
+        for (int k = 1; k < pool->nworkers && !got; k++) {
+            int victim = (w->id + k) % pool->nworkers;
+            got = deque_steal_half(&pool->deques[victim], stolen);
+        }
+        if (got) {
+            if (got > 1 && !pool_push(pool, w->id, stolen + 1, got - 1)) {
+                for (int k = 1; k < got; k++) run_task(pool, w->id, stolen[k]);
+            }
+            run_task(pool, w->id, stolen[0]);
+        } else {
+            pool_wait(pool, epoch);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Sort array of pointers in the order defined by the given comparison function
+ * using a pool of worker threads. The calling thread partitions the range and
+ * works as one of the workers; sub-ranges above 8192 elements are pushed to the
+ * worker's deque, idle workers steal half of another worker's queued ranges
+ * and sleep on a condition variable while there is none to steal, and smaller
+ * ranges are finished with the sequential introsort.
+ *
+ * @param *a[] - array of void pointers.
+ * @param left - the start index of pointer in array.
+ * @param right - the end index of pointer in array
+ * @param (*cmp) - pointer to a comparison function used to compaire pointers by their pointed values.
+ * @param nthreads - number of threads to use, <= 0 for one per online CPU.
+ */
+void my_sort_parallel(void *a[], int left, int right, int (*cmp)(void*, void*), int nthreads) {
     if (!a || left >= right || !cmp) return;
+    if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads <= 1 || right - left + 1 <= PARALLEL_CUTOFF) {
+        my_sort(a, left, right, cmp);
+        return;
+    }
 
-    int i = left + 1;
-    int j = right;
+    SORT_POOL pool = {a, {cmp}, nthreads, NULL, right - left + 1};
+    pthread_mutex_init(&pool.idle_lock, NULL);
+    pthread_cond_init(&pool.idle, NULL);
+    pthread_t *threads = malloc(nthreads * sizeof *threads);
+    SORT_WORKER *workers = malloc(nthreads * sizeof *workers);
+    pool.deques = calloc(nthreads, sizeof *pool.deques);
+    if (!threads || !workers || !pool.deques) {
+        free(threads);
+        free(workers);
+        free(pool.deques);
+        pthread_mutex_destroy(&pool.idle_lock);
+        pthread_cond_destroy(&pool.idle);
+        my_sort(a, left, right, cmp);
+        return;
+    }
+    for (int i = 0; i < nthreads; i++) {
+        pthread_mutex_init(&pool.deques[i].lock, NULL);
+        workers[i].pool = &pool;
+        workers[i].id = i;
+    }
+
+    SORT_TASK root = {left, right, 2 * mysort_log2(right - left + 1)};
+    if (!deque_push(&pool.deques[0], &root, 1)) {
+        run_task(&pool, 0, root);
+    }
 
-    while (i <= j) {
-        while (i <= right && cmp(a[i], a[left]) <= 0) i++;
-        while (j >= left && cmp(a[j], a[left]) > 0)  j--;
-        if (i < j) swap(&a[i], &a[j]);
+    int started = 1;
+    for (; started < nthreads; started++) {
+        if (pthread_create(&threads[started], NULL, sort_worker, &workers[started]) != 0)
+            break;
     }
-    swap(&a[left], &a[j]);
+    sort_worker(&workers[0]);
+    for (int i = 1; i < started; i++)
+        pthread_join(threads[i], NULL);
 
-    if (left < j - 1)  my_sort(a, left, j - 1, cmp);
-    if (j + 1 < right) my_sort(a, j + 1, right, cmp);
+    for (int i = 0; i < nthreads; i++) {
+        pthread_mutex_destroy(&pool.deques[i].lock);
+        free(pool.deques[i].tasks);
+    }
+    free(pool.deques);
+    pthread_mutex_destroy(&pool.idle_lock);
+    pthread_cond_destroy(&pool.idle);
+    free(workers);
+    free(threads);
 }
@@ -5,13 +5,80 @@
  #ifndef MYSORT_H
  #define MYSORT_H 
  
+ #include <stddef.h>
+ #include <stdint.h>
+ 
+ /*
+  * Building with -DMYSORT_STATS makes the sorts count comparisons and swaps in
+  * these globals, for the benchmark driver. Comparator-based sorts count through
+  * the caller's comparator, which should add to mysort_compares itself.
+  */
+ #ifdef MYSORT_STATS
+ extern unsigned long long mysort_compares;
+ extern unsigned long long mysort_swaps;
+ // relaxed load and store rather than a locked add, so counting stays cheap;
+ // concurrent updates from my_sort_parallel workers may be lost
+ #define MYSORT_COUNT(counter, k) \
+   __atomic_store_n(&(counter), __atomic_load_n(&(counter), __ATOMIC_RELAXED) + (k), __ATOMIC_RELAXED)
+ #else
+ #define MYSORT_COUNT(counter, k) ((void)0)
+ #endif
+ 
+ // float sort key with the index of the object it was taken from
+ typedef struct {
+   float key;
+   uint32_t index;
+ } KEYPAIR;
+ 
+ // scratch space for tim_sort, reusable across calls; start with {NULL, 0}
+ typedef struct {
+   void **buf;
+   int cap;
+ } SORT_BUFFER;
+ 
  // your code document
  void select_sort(void *a[], int left, int right);
  
- // your code document
+ // introsort pointers to floats into increasing order, O(n log n) worst case
  void quick_sort(void *a[], int left, int right);
  
- // your code document
+ // introsort pointers into the order defined by cmp, O(n log n) worst case
  void my_sort(void *a[], int left, int right, int (*cmp)(void*, void*) );
  
+ // introsort an array of floats in place into increasing order
+ void float_sort(float a[], int n);
+ 
+ // move the element of sorted rank k into a[k], smaller ones before it, larger after; O(n)
+ void my_select(void *a[], int left, int right, int k, int (*cmp)(void*, void*));
+ 
+ // sort the k smallest elements into a[left..left+k-1]; O(n log k)
+ void my_partial_sort(void *a[], int left, int right, int k, int (*cmp)(void*, void*));
+ 
+ // move the k-th smallest float into a[k]; O(n)
+ void float_select(float a[], int n, int k);
+ 
+ // my_sort with three-way partitioning, for keys with many duplicates
+ void my_sort_3way(void *a[], int left, int right, int (*cmp)(void*, void*) );
+ 
+ // radix sort pointers by the float at key_offset into increasing order; 0 if out of memory
+ int radix_sort(void *a[], int left, int right, size_t key_offset);
+ 
+ // radix sort pointers by the float at key_offset into decreasing order; 0 if out of memory
+ int radix_sort_desc(void *a[], int left, int right, size_t key_offset);
+ 
+ // radix sort (key, index) pairs into increasing key order; 0 if out of memory
+ int pair_sort(KEYPAIR p[], int n);
+ 
+ // radix sort (key, index) pairs into decreasing key order; 0 if out of memory
+ int pair_sort_desc(KEYPAIR p[], int n);
+ 
+ // stable natural merge sort with galloping; buf may be NULL. 0 if out of memory
+ int tim_sort(void *a[], int left, int right, int (*cmp)(void*, void*), SORT_BUFFER *buf);
+ 
+ // release the memory of a tim_sort scratch buffer
+ void sort_buffer_free(SORT_BUFFER *buf);
+ 
+ // my_sort on a work-stealing pool of nthreads threads (<= 0: one per CPU)
+ void my_sort_parallel(void *a[], int left, int right, int (*cmp)(void*, void*), int nthreads);
+ 
  #endif
\ No newline at end of file
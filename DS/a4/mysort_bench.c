@@ -0,0 +1,358 @@
+/*
+--------------------------------------------------
+Project: a4q1
+File:    mysort_bench.c
+About:   benchmark driver for the sorts in mysort.h
+Version: 2026-10-18
+--------------------------------------------------
+
+Usage: sortbench [--min N] [--max N] [--reps R] [--threads T] [--csv | --json]
+
+Sweeps n = min, 10*min, ..., max (default 1e2 .. 1e6, at most 1e8) over
+several input distributions and every sort in mysort.h, and
+reports per algorithm, distribution and n the median and 95th percentile
+wall time in ns per element, or comparisons and swaps per element (median
+across repetitions). The counters cost a load and store per comparison and
+swap, so one binary cannot report both honestly: the plain build
+(sortbench) reports times, and the -DMYSORT_STATS build (sortbench_counts)
+reports counts, leaving the other columns empty. Quadratic select_sort only
+runs up to n = 1e4. my_partial_sort sorts the smallest tenth of the input.
+my_select and float_select are left out on purpose: they place one rank and
+leave the rest unsorted, so they are not sorts to compare here.
+
+Memory: the inputs take 12 bytes per element (the floats plus one buffer
+shared by the pointer, pair and float arrays, since only one algorithm runs
+at a time), 1.2 GB at n = 1e8; radix_sort allocates another 16 bytes per
+element while it runs, so peak use at 1e8 is about 2.8 GB.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "mysort.h"
+
+#ifndef MYSORT_STATS
+unsigned long long mysort_compares;
+unsigned long long mysort_swaps;
+#define MYSORT_COUNT_CMP() ((void)0)
+#define COUNTING 0
+#else
+#define MYSORT_COUNT_CMP() MYSORT_COUNT(mysort_compares, 1)
+#define COUNTING 1
+#endif
+
+#define SELECT_SORT_MAX 10000
+#define MAX_REPS 101
+#define PARTIAL_FRACTION 10
+
+enum { OUT_TABLE, OUT_CSV, OUT_JSON };
+
+static int threads = 0;
+static SORT_BUFFER tim_buf = {NULL, 0};
+
+int cmp_float(void *x, void *y) {
+	MYSORT_COUNT_CMP();
+	float a = *(float*)x;
+	float b = *(float*)y;
+	if (a > b) return 1;
+	else if (a < b) return -1;
+	else return 0;
+}
+
+/*
+ * Input distributions. Generated with a fixed-seed xorshift generator so runs
+ * are repeatable across hosts.
+ */
+typedef void (*GENERATOR)(float *d, int n, uint64_t *seed);
+
+static uint32_t next_random(uint64_t *s) {
+	*s ^= *s << 13;
+	*s ^= *s >> 7;
+	*s ^= *s << 17;
+	return (uint32_t)(*s >> 32);
+}
+
+static void gen_random(float *d, int n, uint64_t *s) {
+	for (int i = 0; i < n; i++) d[i] = (float)next_random(s);
+}
+
+static void gen_sorted(float *d, int n, uint64_t *s) {
+	for (int i = 0; i < n; i++) d[i] = (float)i;
+}
+
+static void gen_reversed(float *d, int n, uint64_t *s) {
+	for (int i = 0; i < n; i++) d[i] = (float)(n - i);
+}
+
+static void gen_organ_pipe(float *d, int n, uint64_t *s) {
+	for (int i = 0; i < n; i++) d[i] = (float)(i < n / 2 ? i : n - i);
+}
+
+static void gen_few_unique(float *d, int n, uint64_t *s) {
+	for (int i = 0; i < n; i++) d[i] = (float)(next_random(s) % 201) / 2.0f;
+}
+
+static void gen_all_equal(float *d, int n, uint64_t *s) {
+	for (int i = 0; i < n; i++) d[i] = 42.0f;
+}
+
+static void gen_sawtooth(float *d, int n, uint64_t *s) {
+	for (int i = 0; i < n; i++) d[i] = (float)(i % 1000);
+}
+
+static const struct {
+	const char *name;
+	GENERATOR gen;
+} distributions[] = {
+	{"random", gen_random},
+	{"sorted", gen_sorted},
+	{"reversed", gen_reversed},
+	{"organ-pipe", gen_organ_pipe},
+	{"few-unique", gen_few_unique},
+	{"all-equal", gen_all_equal},
+	{"sawtooth", gen_sawtooth},
+};
+
+/*
+ * Algorithms. d holds the input; prep copies it into the pointer, pair or
+ * float array the algorithm sorts, outside the timed region.
+ */
+typedef struct {
+	float *d;
+	void **a;
+	KEYPAIR *p;
+	float *f;
+	int n;
+} BENCH_DATA;
+
+static void prep_pointers(BENCH_DATA *b) {
+	for (int i = 0; i < b->n; i++) b->a[i] = &b->d[i];
+}
+static void prep_pairs(BENCH_DATA *b) {
+	for (int i = 0; i < b->n; i++) {
+		b->p[i].key = b->d[i];
+		b->p[i].index = (uint32_t)i;
+	}
+}
+static void prep_floats(BENCH_DATA *b) {
+	memcpy(b->f, b->d, b->n * sizeof *b->f);
+}
+
+// elements my_partial_sort sorts: the smallest tenth, at least one
+static int partial_k(int n) {
+	return n / PARTIAL_FRACTION > 0 ? n / PARTIAL_FRACTION : 1;
+}
+
+static void run_select_sort(BENCH_DATA *b) { select_sort(b->a, 0, b->n - 1); }
+static void run_quick_sort(BENCH_DATA *b) { quick_sort(b->a, 0, b->n - 1); }
+static void run_my_sort(BENCH_DATA *b) { my_sort(b->a, 0, b->n - 1, cmp_float); }
+static void run_my_sort_3way(BENCH_DATA *b) { my_sort_3way(b->a, 0, b->n - 1, cmp_float); }
+static void run_my_sort_parallel(BENCH_DATA *b) { my_sort_parallel(b->a, 0, b->n - 1, cmp_float, threads); }
+static void run_tim_sort(BENCH_DATA *b) { tim_sort(b->a, 0, b->n - 1, cmp_float, &tim_buf); }
+static void run_radix_sort(BENCH_DATA *b) { radix_sort(b->a, 0, b->n - 1, 0); }
+static void run_radix_sort_desc(BENCH_DATA *b) { radix_sort_desc(b->a, 0, b->n - 1, 0); }
+static void run_pair_sort(BENCH_DATA *b) { pair_sort(b->p, b->n); }
+static void run_pair_sort_desc(BENCH_DATA *b) { pair_sort_desc(b->p, b->n); }
+static void run_my_partial_sort(BENCH_DATA *b) {
+	my_partial_sort(b->a, 0, b->n - 1, partial_k(b->n), cmp_float);
+}
+static void run_float_sort(BENCH_DATA *b) { float_sort(b->f, b->n); }
+
+static int check_pointers(BENCH_DATA *b) {
+	for (int i = 1; i < b->n; i++)
+		if (*(float*)b->a[i - 1] > *(float*)b->a[i]) return 0;
+	return 1;
+}
+static int check_pointers_desc(BENCH_DATA *b) {
+	for (int i = 1; i < b->n; i++)
+		if (*(float*)b->a[i - 1] < *(float*)b->a[i]) return 0;
+	return 1;
+}
+// the first k in order, and none of the rest below the k-th
+static int check_partial(BENCH_DATA *b) {
+	int k = partial_k(b->n);
+	for (int i = 1; i < b->n; i++) {
+		float prev = *(float*)b->a[i < k ? i - 1 : k - 1];
+		if (*(float*)b->a[i] < prev) return 0;
+	}
+	return 1;
+}
+static int check_pairs_desc(BENCH_DATA *b) {
+	for (int i = 1; i < b->n; i++)
+		if (b->p[i - 1].key < b->p[i].key) return 0;
+	return 1;
+}
+static int check_pairs(BENCH_DATA *b) {
+	for (int i = 1; i < b->n; i++)
+		if (b->p[i - 1].key > b->p[i].key) return 0;
+	return 1;
+}
+static int check_floats(BENCH_DATA *b) {
+	for (int i = 1; i < b->n; i++)
+		if (b->f[i - 1] > b->f[i]) return 0;
+	return 1;
+}
+
+static const struct {
+	const char *name;
+	void (*prep)(BENCH_DATA *);
+	void (*run)(BENCH_DATA *);
+	int (*check)(BENCH_DATA *);
+	int max_n;
+} algorithms[] = {
+	{"select_sort", prep_pointers, run_select_sort, check_pointers, SELECT_SORT_MAX},
+	{"quick_sort", prep_pointers, run_quick_sort, check_pointers, 0},
+	{"my_sort", prep_pointers, run_my_sort, check_pointers, 0},
+	{"my_sort_3way", prep_pointers, run_my_sort_3way, check_pointers, 0},
+	{"my_sort_parallel", prep_pointers, run_my_sort_parallel, check_pointers, 0},
+	{"tim_sort", prep_pointers, run_tim_sort, check_pointers, 0},
+	{"my_partial_sort", prep_pointers, run_my_partial_sort, check_partial, 0},
+	{"radix_sort", prep_pointers, run_radix_sort, check_pointers, 0},
+	{"radix_sort_desc", prep_pointers, run_radix_sort_desc, check_pointers_desc, 0},
+	{"pair_sort", prep_pairs, run_pair_sort, check_pairs, 0},
+	{"pair_sort_desc", prep_pairs, run_pair_sort_desc, check_pairs_desc, 0},
+	{"float_sort", prep_floats, run_float_sort, check_floats, 0},
+};
+
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *x, const void *y) {
+	double a = *(const double*)x;
+	double b = *(const double*)y;
+	return (a > b) - (a < b);
+}
+
+// value at quantile q of sorted v[0..n-1], nearest rank
+static double quantile(const double *v, int n, double q) {
+	int i = (int)(q * n + 0.999999) - 1;
+	if (i < 0) i = 0;
+	if (i >= n) i = n - 1;
+	return v[i];
+}
+
+static void print_header(int format) {
+	if (format == OUT_CSV)
+		printf("algorithm,distribution,n,reps,ns_per_elem_median,ns_per_elem_p95,"
+		       "compares_per_elem,swaps_per_elem,sorted\n");
+	else if (format == OUT_JSON)
+		printf("[\n");
+	else
+		printf("%-17s %-11s %10s %12s %12s %10s %10s\n", "algorithm", "distribution",
+		       "n", "ns/elem p50", "ns/elem p95", "cmp/elem", "swap/elem");
+}
+
+// v with the given decimals if this build measures it, else the empty mark
+static const char *field(char *buf, int live, double v, int decimals, const char *empty) {
+	if (!live) return empty;
+	snprintf(buf, 32, "%.*f", decimals, v);
+	return buf;
+}
+
+static void print_row(int format, int first, const char *alg, const char *dist, int n,
+		int reps, double p50, double p95, double cmps, double swaps, int sorted) {
+	char f1[32], f2[32], f3[32], f4[32];
+	if (format == OUT_CSV) {
+		printf("%s,%s,%d,%d,%s,%s,%s,%s,%d\n", alg, dist, n, reps,
+		       field(f1, !COUNTING, p50, 3, ""), field(f2, !COUNTING, p95, 3, ""),
+		       field(f3, COUNTING, cmps, 3, ""), field(f4, COUNTING, swaps, 3, ""), sorted);
+	} else if (format == OUT_JSON) {
+		printf("%s  {\"algorithm\": \"%s\", \"distribution\": \"%s\", \"n\": %d, \"reps\": %d, "
+		       "\"ns_per_elem_median\": %s, \"ns_per_elem_p95\": %s, "
+		       "\"compares_per_elem\": %s, \"swaps_per_elem\": %s, \"sorted\": %s}",
+		       first ? "" : ",\n", alg, dist, n, reps,
+		       field(f1, !COUNTING, p50, 3, "null"), field(f2, !COUNTING, p95, 3, "null"),
+		       field(f3, COUNTING, cmps, 3, "null"), field(f4, COUNTING, swaps, 3, "null"),
+		       sorted ? "true" : "false");
+	} else {
+		printf("%-17s %-11s %10d %12s %12s %10s %10s%s\n", alg, dist, n,
+		       field(f1, !COUNTING, p50, 2, "-"), field(f2, !COUNTING, p95, 2, "-"),
+		       field(f3, COUNTING, cmps, 2, "-"), field(f4, COUNTING, swaps, 2, "-"),
+		       sorted ? "" : "  NOT SORTED");
+	}
+	fflush(stdout);
+}
+
+int main(int argc, char *args[]) {
+	long min_n = 100, max_n = 1000000;
+	int reps = 5;
+	int format = OUT_TABLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(args[i], "--csv") == 0) format = OUT_CSV;
+		else if (strcmp(args[i], "--json") == 0) format = OUT_JSON;
+		else if (strcmp(args[i], "--min") == 0 && i + 1 < argc) min_n = atol(args[++i]);
+		else if (strcmp(args[i], "--max") == 0 && i + 1 < argc) max_n = atol(args[++i]);
+		else if (strcmp(args[i], "--reps") == 0 && i + 1 < argc) reps = atoi(args[++i]);
+		else if (strcmp(args[i], "--threads") == 0 && i + 1 < argc) threads = atoi(args[++i]);
+		else {
+			fprintf(stderr, "usage: %s [--min N] [--max N] [--reps R] [--threads T] [--csv | --json]\n",
+			        args[0]);
+			return 1;
+		}
+	}
+	if (min_n < 2) min_n = 2;
+	if (max_n > 100000000) max_n = 100000000;
+	if (reps < 1) reps = 1;
+	if (reps > MAX_REPS) reps = MAX_REPS;
+
+	// a, p and f alias one buffer sized for the widest; prep refills it per run
+	BENCH_DATA b;
+	size_t width = sizeof *b.a > sizeof *b.p ? sizeof *b.a : sizeof *b.p;
+	void *work = malloc(max_n * width);
+	b.d = malloc(max_n * sizeof *b.d);
+	b.a = work;
+	b.p = work;
+	b.f = work;
+	if (!b.d || !work) {
+		fprintf(stderr, "out of memory for n = %ld\n", max_n);
+		return 1;
+	}
+
+	int nalg = sizeof algorithms / sizeof *algorithms;
+	int ndist = sizeof distributions / sizeof *distributions;
+	double ns[MAX_REPS], cmps[MAX_REPS], swaps[MAX_REPS];
+	int first = 1;
+
+	print_header(format);
+	for (long n = min_n; n <= max_n; n *= 10) {
+		b.n = (int)n;
+		for (int di = 0; di < ndist; di++) {
+			uint64_t seed = 0x9E3779B97F4A7C15ull;
+			distributions[di].gen(b.d, b.n, &seed);
+			for (int ai = 0; ai < nalg; ai++) {
+				if (algorithms[ai].max_n && n > algorithms[ai].max_n) continue;
+				int sorted = 1;
+				for (int r = 0; r < reps; r++) {
+					algorithms[ai].prep(&b);
+					mysort_compares = mysort_swaps = 0;
+					double t = now_ns();
+					algorithms[ai].run(&b);
+					ns[r] = (now_ns() - t) / n;
+					cmps[r] = (double)mysort_compares / n;
+					swaps[r] = (double)mysort_swaps / n;
+					sorted &= algorithms[ai].check(&b);
+				}
+				qsort(ns, reps, sizeof *ns, cmp_double);
+				qsort(cmps, reps, sizeof *cmps, cmp_double);
+				qsort(swaps, reps, sizeof *swaps, cmp_double);
+				print_row(format, first, algorithms[ai].name, distributions[di].name, b.n, reps,
+				          quantile(ns, reps, 0.5), quantile(ns, reps, 0.95),
+				          quantile(cmps, reps, 0.5), quantile(swaps, reps, 0.5), sorted);
+				first = 0;
+			}
+		}
+	}
+	if (format == OUT_JSON) printf("\n]\n");
+
+	sort_buffer_free(&tim_buf);
+	free(b.d);
+	free(work);
+	return 0;
+}
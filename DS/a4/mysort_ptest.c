@@ -10,7 +10,9 @@ Version: 2025-08-28
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <math.h>
 #include "mysort.h"
 
 #define FLOATFORMAT "%.0f"
@@ -116,6 +118,227 @@ void test_my_sort() {
 	printf("\n");
 }
 
+void test_my_sort_3way() {
+	printf("------------------\n");
+	printf("Test: my_sort_3way\n\n");
+	float *a[MAX_LEN];
+	int count = sizeof tests / sizeof *tests;
+	for (int i = 0; i < count; i++) {
+		int left = tests[i][0];
+		int right = tests[i][1];
+		copy_data_address(test_data, a, left, right);
+		printf("my_sort_3way(");
+		display_array(a, left, right);
+		printf("): ");
+		my_sort_3way((void*) a, left, right, cmp1);
+		display_array(a, left, right);
+		printf("\n");
+	}
+	printf("\n");
+}
+
+void test_radix_sort() {
+	printf("------------------\n");
+	printf("Test: radix_sort\n\n");
+	float *a[MAX_LEN];
+	int count = sizeof tests / sizeof *tests;
+	for (int i = 0; i < count; i++) {
+		int left = tests[i][0];
+		int right = tests[i][1];
+		copy_data_address(test_data, a, left, right);
+		printf("radix_sort(");
+		display_array(a, left, right);
+		printf("): ");
+		radix_sort((void*) a, left, right, 0);
+		display_array(a, left, right);
+		printf("\n");
+		printf("radix_sort_desc(");
+		display_array(a, left, right);
+		printf("): ");
+		radix_sort_desc((void*) a, left, right, 0);
+		display_array(a, left, right);
+		printf("\n");
+	}
+	printf("\n");
+}
+
+void test_my_select() {
+	printf("------------------\n");
+	printf("Test: my_select and my_partial_sort\n\n");
+	float *a[MAX_LEN];
+	int count = sizeof tests / sizeof *tests;
+	for (int i = 0; i < count; i++) {
+		int left = tests[i][0];
+		int right = tests[i][1];
+		int mid = left + (right - left) / 2;
+		copy_data_address(test_data, a, left, right);
+		printf("my_select(");
+		display_array(a, left, right);
+		printf(", %d): ", mid - left);
+		my_select((void*) a, left, right, mid, cmp1);
+		printf(FLOATFORMAT, *a[mid]);
+		printf("\n");
+		copy_data_address(test_data, a, left, right);
+		printf("my_partial_sort(");
+		display_array(a, left, right);
+		printf(", 3): ");
+		my_partial_sort((void*) a, left, right, 3, cmp1);
+		display_array(a, left, left + 2);
+		printf("\n");
+	}
+	printf("\n");
+}
+
+void test_tim_sort() {
+	printf("------------------\n");
+	printf("Test: tim_sort\n\n");
+	float *a[MAX_LEN];
+	SORT_BUFFER buf = {NULL, 0};
+	int count = sizeof tests / sizeof *tests;
+	for (int i = 0; i < count; i++) {
+		int left = tests[i][0];
+		int right = tests[i][1];
+		copy_data_address(test_data, a, left, right);
+		printf("tim_sort(");
+		display_array(a, left, right);
+		printf("): ");
+		tim_sort((void*) a, left, right, cmp1, &buf);
+		display_array(a, left, right);
+		printf("\n");
+	}
+	sort_buffer_free(&buf);
+	printf("\n");
+}
+
+// key with its input position, for checking stability
+typedef struct {
+	float key;
+	int seq;
+} ITEM;
+
+int cmp_item(void *x, void *y) {
+	float a = ((ITEM*)x)->key;
+	float b = ((ITEM*)y)->key;
+	return (a > b) - (a < b);
+}
+
+/*
+ * Keys for the tim_sort stress test: 0 uniform, 1 few distinct values,
+ * 2 ascending and descending runs of random length with repeated keys,
+ * 3 sorted with a few random swaps.
+ */
+void fill_items(ITEM *d, int n, int kind) {
+	for (int i = 0; i < n; i++) {
+		d[i].seq = i;
+		d[i].key = kind == 1 ? rand() % 20 : kind == 3 ? i / 4 : rand() % 100000;
+	}
+	if (kind == 2) {
+		for (int i = 0; i < n;) {
+			int len = 1 + rand() % 300, dir = rand() % 2;
+			float base = rand() % 1000;
+			for (int j = 0; j < len && i < n; j++, i++)
+				d[i].key = base + (dir ? j / 3 : -j / 3);
+		}
+	} else if (kind == 3) {
+		for (int k = 0; k < n / 100; k++) {
+			int i = rand() % n, j = rand() % n;
+			float t = d[i].key;
+			d[i].key = d[j].key;
+			d[j].key = t;
+		}
+	}
+}
+
+void test_tim_sort_large() {
+	printf("------------------\n");
+	printf("Test: tim_sort, large inputs\n\n");
+	int sizes[] = {65, 1000, 50000, 200000};
+	const char *kinds[] = {"random", "few-unique", "runs", "nearly-sorted"};
+	ITEM *d = malloc(200000 * sizeof *d);
+	void **a = malloc(200000 * sizeof *a);
+	SORT_BUFFER buf = {NULL, 0};
+	if (!d || !a) {
+		free(d);
+		free(a);
+		return;
+	}
+	srand(9);
+	for (int kind = 0; kind < 4; kind++) {
+		int ok = 1;
+		for (int s = 0; s < 4; s++) {
+			int n = sizes[s];
+			fill_items(d, n, kind);
+			for (int i = 0; i < n; i++) a[i] = &d[i];
+			ok = ok && tim_sort(a, 0, n - 1, cmp_item, &buf);
+			for (int i = 1; i < n; i++) {
+				const ITEM *x = a[i - 1], *y = a[i];
+				if (x->key > y->key || (x->key == y->key && x->seq > y->seq)) ok = 0;
+			}
+		}
+		printf("tim_sort(%s, n up to 200000) sorted and stable: %s\n", kinds[kind], ok ? "yes" : "no");
+	}
+	sort_buffer_free(&buf);
+	free(d);
+	free(a);
+	printf("\n");
+}
+
+int cmp_float_bits(const void *x, const void *y) {
+	unsigned int a, b;
+	memcpy(&a, x, sizeof a);
+	memcpy(&b, y, sizeof b);
+	return (a > b) - (a < b);
+}
+
+void test_float_sort_nan() {
+	printf("------------------\n");
+	printf("Test: float_sort with NaN and inf\n\n");
+	float pick[] = {NAN, INFINITY, -INFINITY, 0, 1, 2, 3, 4};
+	float d[200], before[200];
+	int cases = 20000, kept = 1, sorted = 1;
+	srand(7);
+	for (int c = 0; c < cases; c++) {
+		int n = 2 + rand() % (c % 4 ? 63 : 199);
+		int nan_ok = c % 2;
+		for (int i = 0; i < n; i++)
+			d[i] = nan_ok ? pick[rand() % 8] : pick[1 + rand() % 7];
+		memcpy(before, d, n * sizeof *d);
+		float_sort(d, n);
+		for (int i = 1; i < n && !nan_ok; i++)
+			if (d[i] < d[i - 1]) sorted = 0;
+		qsort(before, n, sizeof *before, cmp_float_bits);
+		qsort(d, n, sizeof *d, cmp_float_bits);
+		if (memcmp(before, d, n * sizeof *d) != 0) kept = 0;
+	}
+	printf("float_sort(%d arrays) keeps every value: %s\n", cases, kept ? "yes" : "no");
+	printf("float_sort without NaN sorted: %s\n\n", sorted ? "yes" : "no");
+}
+
+void test_my_sort_parallel() {
+	printf("------------------\n");
+	printf("Test: my_sort_parallel\n\n");
+	int n = 200000;
+	float *d = malloc(n * sizeof *d);
+	float **a = malloc(n * sizeof *a);
+	if (!d || !a) {
+		free(d);
+		free(a);
+		return;
+	}
+	for (int i = 0; i < n; i++) {
+		d[i] = rand() % 1000;
+	}
+	copy_data_address(d, a, 0, n - 1);
+	my_sort_parallel((void*) a, 0, n - 1, cmp1, 4);
+	int sorted = 1;
+	for (int i = 1; i < n; i++) {
+		if (*a[i - 1] < *a[i]) sorted = 0;
+	}
+	printf("my_sort_parallel(%d numbers, 4 threads) sorted: %s\n\n", n, sorted ? "yes" : "no");
+	free(d);
+	free(a);
+}
+
 
 void time_test_sort() {
 	printf("------------------\n");
@@ -138,7 +361,7 @@ void time_test_sort() {
 		select_sort((void*) a, 0, MAX_LEN - 1);
 	}
 	clock_t t2 = clock();
-	double time_span1 = (double) t2 - t1;
+	double time_span1 = 1000.0 * (t2 - t1) / CLOCKS_PER_SEC;
 	printf("time_span(select_sort(%d numbers) for %d times)(ms):%0.1f\n", MAX_LEN,
 			m1, time_span1);
 
@@ -150,13 +373,55 @@ void time_test_sort() {
 		quick_sort((void*) a, 0, MAX_LEN - 1);
 	}
 	t2 = clock();
-	double time_span2 = (double) t2 - t1;
+	double time_span2 = 1000.0 * (t2 - t1) / CLOCKS_PER_SEC;
 	printf("time_span(quick_sort(%d numbers) for %d times)(ms):%0.1f\n", MAX_LEN,
 			m2, time_span2);
 
 	printf(
 			"time_span(select_sort(%d numbers))/time_span(quick_sort(%d numbers)):%0.1f\n",
-			MAX_LEN, MAX_LEN, (time_span1 / 10) / (time_span2 / m2));
+			MAX_LEN, MAX_LEN, (time_span1 / m1) / (time_span2 / m2));
+	printf("(see sortbench for the full benchmark)\n");
+}
+
+
+/*
+ * Duplicate-heavy benchmark: n scores drawn from the 201 half-point values in
+ * [0, 100], sorted in decreasing order by my_sort and my_sort_3way.
+ */
+void time_test_duplicates(int n) {
+	printf("------------------\n");
+	printf("Test: sorting %d scores with 201 distinct values\n\n", n);
+	float *d = malloc(n * sizeof *d);
+	float **a = malloc(n * sizeof *a);
+	if (!d || !a) {
+		printf("out of memory\n");
+		free(d);
+		free(a);
+		return;
+	}
+
+	srand(time(NULL));
+	for (int i = 0; i < n; i++) {
+		d[i] = (rand() % 201) / 2.0f;
+	}
+
+	copy_data_address(d, a, 0, n - 1);
+	clock_t t1 = clock();
+	my_sort((void*) a, 0, n - 1, cmp1);
+	clock_t t2 = clock();
+	double ms1 = 1000.0 * (t2 - t1) / CLOCKS_PER_SEC;
+	printf("time_span(my_sort)(ms):%0.1f\n", ms1);
+
+	copy_data_address(d, a, 0, n - 1);
+	t1 = clock();
+	my_sort_3way((void*) a, 0, n - 1, cmp1);
+	t2 = clock();
+	double ms2 = 1000.0 * (t2 - t1) / CLOCKS_PER_SEC;
+	printf("time_span(my_sort_3way)(ms):%0.1f\n", ms2);
+	printf("time_span(my_sort)/time_span(my_sort_3way):%0.1f\n", ms1 / ms2);
+
+	free(d);
+	free(a);
 }
 
 
@@ -166,6 +431,15 @@ int main(int argc, char *args[])
 	  test_select_sort();
 	  test_quick_sort();
 	  test_my_sort();
+	  test_my_sort_3way();
+	  test_radix_sort();
+	  test_my_select();
+	  test_tim_sort();
+	  test_tim_sort_large();
+	  test_float_sort_nan();
+	  test_my_sort_parallel();
+	} else if (strcmp(args[1], "dup") == 0) {
+		time_test_duplicates(argc > 2 ? atoi(args[2]) : 10000000);
 	} else {
 		time_test_sort();
 	}
@@ -0,0 +1,267 @@
+/*
+ * Type-specialized sorting algorithms.
+ *
+ * MYSORT_DEFINE(prefix, T, LESS) expands to static inline functions that sort
+ * arrays of T with the introsort used by mysort.c. LESS(x, y, ctx) must be an
+ * expression-like macro that is nonzero when x orders before y; because it is
+ * expanded in place, the comparison is inlined instead of being called through
+ * a function pointer. ctx is passed through unchanged and may be ignored.
+ *
+ * Example, WORD records by decreasing count:
+ *
+ *   #define WORD_COUNT_LESS(x, y, ctx) ((x).count > (y).count)
+ *   MYSORT_DEFINE(word, WORD, WORD_COUNT_LESS)
+ *   ...
+ *   word_sort(words, n, NULL);
+ *
+ * MYSORT_DEFINE_EX(prefix, T, LESS, BASE_N, BASE_SORT) is the same, but ranges of
+ * at most BASE_N elements are finished by BASE_SORT(T *a, int left, int right,
+ * const void *ctx) instead of insertion sort, e.g. with a sorting network.
+ *
+ * MYSORT_DEFINE_EQ(prefix, T, LESS, EQUAL, BASE_N, BASE_SORT) also takes the
+ * equality test of the three-way partition, EQUAL(LESS, x, y, ctx). The
+ * default, MYSORT_EQUIV, is !LESS(x, y) && !LESS(y, x); a three-way comparator
+ * can answer with one call instead of two, as the vp instantiation does.
+ *
+ * Generated entry points (all ranges are inclusive, [left, right]):
+ *   prefix_sort(T *a, int n, const void *ctx)            introsort
+ *   prefix_sort3(T *a, int n, const void *ctx)           introsort, three-way partitioning
+ *   prefix_intro_sort(a, left, right, depth, ctx)        introsort with explicit depth budget
+ *   prefix_intro_sort3(a, left, right, depth, ctx)
+ *   prefix_heap_sort(a, left, right, ctx)
+ *   prefix_insertion_sort(a, left, right, ctx)
+ *   prefix_partition(a, left, right, ctx)                returns pivot index
+ *   prefix_partition3(a, left, right, &lt, &gt, ctx)     equal keys end in [lt, gt]
+ *   prefix_select(a, left, right, k, ctx)                a[k] as in sorted order, O(n)
+ *   prefix_partial_sort(a, left, right, k, ctx)          smallest k sorted to the front
+ */
+
+#ifndef MYSORT_TEMPLATE_H
+#define MYSORT_TEMPLATE_H
+
+#include "mysort.h"
+
+#define MYSORT_INSERTION_CUTOFF 16
+#define MYSORT_NINTHER_CUTOFF 128
+
+// floor(log2(n)) for n >= 1
+static inline int mysort_log2(int n) {
+    int k = 0;
+    while (n >>= 1) k++;
+    return k;
+}
+
+// x and y are equivalent under LESS
+#define MYSORT_EQUIV(LESS, x, y, ctx) (!LESS(x, y, ctx) && !LESS(y, x, ctx))
+
+#define MYSORT_DEFINE(prefix, T, LESS)                                              \
+    MYSORT_DEFINE_EX(prefix, T, LESS, MYSORT_INSERTION_CUTOFF, prefix##_insertion_sort)
+
+#define MYSORT_DEFINE_EX(prefix, T, LESS, BASE_N, BASE_SORT)                        \
+    MYSORT_DEFINE_EQ(prefix, T, LESS, MYSORT_EQUIV, BASE_N, BASE_SORT)
+
+#define MYSORT_DEFINE_EQ(prefix, T, LESS, EQUAL, BASE_N, BASE_SORT)                 \
+                                                                                    \
+static inline void prefix##_swap(T *x, T *y) {                                      \
+    MYSORT_COUNT(mysort_swaps, 1);                                                  \
+    T t = *x;                                                                       \
+    *x = *y;                                                                        \
+    *y = t;                                                                         \
+}                                                                                   \
+                                                                                    \
+static inline void prefix##_insertion_sort(T *a, int left, int right,               \
+                                           const void *ctx) {                       \
+    for (int i = left + 1; i <= right; ++i) {                                       \
+        T v = a[i];                                                                 \
+        int j = i - 1;                                                              \
+        while (j >= left && LESS(v, a[j], ctx)) {                                   \
+            a[j + 1] = a[j];                                                        \
+            j--;                                                                    \
+        }                                                                           \
+        a[j + 1] = v;                                                               \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static inline void prefix##_sift_down(T *a, int left, int i, int n,                 \
+                                      const void *ctx) {                            \
+    T v = a[left + i];                                                              \
+    for (;;) {                                                                      \
+        int c = 2 * i + 1;                                                          \
+        if (c >= n) break;                                                          \
+        if (c + 1 < n && LESS(a[left + c], a[left + c + 1], ctx)) c++;              \
+        if (!LESS(v, a[left + c], ctx)) break;                                      \
+        a[left + i] = a[left + c];                                                  \
+        i = c;                                                                      \
+    }                                                                               \
+    a[left + i] = v;                                                                \
+}                                                                                   \
+                                                                                    \
+static inline void prefix##_heap_sort(T *a, int left, int right,                    \
+                                      const void *ctx) {                            \
+    int n = right - left + 1;                                                       \
+    for (int i = n / 2 - 1; i >= 0; --i)                                            \
+        prefix##_sift_down(a, left, i, n, ctx);                                     \
+    for (int end = n - 1; end > 0; --end) {                                         \
+        prefix##_swap(&a[left], &a[left + end]);                                    \
+        prefix##_sift_down(a, left, 0, end, ctx);                                   \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static inline int prefix##_median3(T *a, int i, int j, int k, const void *ctx) {    \
+    if (LESS(a[i], a[j], ctx)) {                                                    \
+        if (LESS(a[j], a[k], ctx)) return j;                                        \
+        return LESS(a[i], a[k], ctx) ? k : i;                                       \
+    }                                                                               \
+    if (LESS(a[i], a[k], ctx)) return i;                                            \
+    return LESS(a[j], a[k], ctx) ? k : j;                                           \
+}                                                                                   \
+                                                                                    \
+static inline int prefix##_choose_pivot(T *a, int left, int right,                  \
+                                        const void *ctx) {                          \
+    int n = right - left + 1;                                                       \
+    int mid = left + n / 2;                                                         \
+    if (n > MYSORT_NINTHER_CUTOFF) {                                                \
+        int s = n / 8;                                                              \
+        int m1 = prefix##_median3(a, left, left + s, left + 2 * s, ctx);            \
+        int m2 = prefix##_median3(a, mid - s, mid, mid + s, ctx);                   \
+        int m3 = prefix##_median3(a, right - 2 * s, right - s, right, ctx);         \
+        return prefix##_median3(a, m1, m2, m3, ctx);                                \
+    }                                                                               \
+    return prefix##_median3(a, left, mid, right, ctx);                              \
+}                                                                                   \
+                                                                                    \
+static inline int prefix##_partition(T *a, int left, int right,                    \
+                                     const void *ctx) {                             \
+    prefix##_swap(&a[left], &a[prefix##_choose_pivot(a, left, right, ctx)]);       \
+    T pv = a[left];                                                                 \
+    int i = left;                                                                   \
+    int j = right + 1;                                                              \
+    for (;;) {                                                                      \
+        while (LESS(a[++i], pv, ctx))                                               \
+            if (i == right) break;                                                  \
+        while (LESS(pv, a[--j], ctx))                                               \
+            if (j == left) break;                                                   \
+        if (i >= j) break;                                                          \
+        prefix##_swap(&a[i], &a[j]);                                                \
+    }                                                                               \
+    prefix##_swap(&a[left], &a[j]);                                                 \
+    return j;                                                                       \
+}                                                                                   \
+                                                                                    \
+static inline void prefix##_partition3(T *a, int left, int right,                  \
+                                       int *lt, int *gt, const void *ctx) {         \
+    prefix##_swap(&a[left], &a[prefix##_choose_pivot(a, left, right, ctx)]);       \
+    T pv = a[left];                                                                 \
+    int i = left, j = right + 1;                                                    \
+    int p = left, q = right + 1;                                                    \
+    for (;;) {                                                                      \
+        while (LESS(a[++i], pv, ctx))                                               \
+            if (i == right) break;                                                  \
+        while (LESS(pv, a[--j], ctx))                                               \
+            if (j == left) break;                                                   \
+        if (i == j && EQUAL(LESS, a[i], pv, ctx))                                   \
+            prefix##_swap(&a[++p], &a[i]);                                          \
+        if (i >= j) break;                                                          \
+        prefix##_swap(&a[i], &a[j]);                                                \
+        if (EQUAL(LESS, a[i], pv, ctx))                                             \
+            prefix##_swap(&a[++p], &a[i]);                                          \
+        if (EQUAL(LESS, a[j], pv, ctx))                                             \
+            prefix##_swap(&a[--q], &a[j]);                                          \
+    }                                                                               \
+    i = j + 1;                                                                      \
+    for (int k = left; k <= p; k++) prefix##_swap(&a[k], &a[j--]);                  \
+    for (int k = right; k >= q; k--) prefix##_swap(&a[k], &a[i++]);                 \
+    *lt = j + 1;                                                                    \
+    *gt = i - 1;                                                                    \
+}                                                                                   \
+                                                                                    \
+static inline void prefix##_intro_sort(T *a, int left, int right, int depth,        \
+                                       const void *ctx) {                           \
+    while (right - left + 1 > (BASE_N)) {                                           \
+        if (depth-- == 0) {                                                         \
+            prefix##_heap_sort(a, left, right, ctx);                                \
+            return;                                                                 \
+        }                                                                           \
+        int p = prefix##_partition(a, left, right, ctx);                            \
+        if (p - left < right - p) {                                                 \
+            prefix##_intro_sort(a, left, p - 1, depth, ctx);                        \
+            left = p + 1;                                                           \
+        } else {                                                                    \
+            prefix##_intro_sort(a, p + 1, right, depth, ctx);                       \
+            right = p - 1;                                                          \
+        }                                                                           \
+    }                                                                               \
+    BASE_SORT(a, left, right, ctx);                                                 \
+}                                                                                   \
+                                                                                    \
+static inline void prefix##_intro_sort3(T *a, int left, int right, int depth,       \
+                                        const void *ctx) {                          \
+    while (right - left + 1 > (BASE_N)) {                                           \
+        if (depth-- == 0) {                                                         \
+            prefix##_heap_sort(a, left, right, ctx);                                \
+            return;                                                                 \
+        }                                                                           \
+        int lt, gt;                                                                 \
+        prefix##_partition3(a, left, right, &lt, &gt, ctx);                        \
+        if (lt - left < right - gt) {                                               \
+            prefix##_intro_sort3(a, left, lt - 1, depth, ctx);                      \
+            left = gt + 1;                                                          \
+        } else {                                                                    \
+            prefix##_intro_sort3(a, gt + 1, right, depth, ctx);                     \
+            right = lt - 1;                                                         \
+        }                                                                           \
+    }                                                                               \
+    BASE_SORT(a, left, right, ctx);                                                 \
+}                                                                                   \
+                                                                                    \
+static inline void prefix##_select(T *a, int left, int right, int k,              \
+                                   const void *ctx) {                               \
+    int depth = 2 * mysort_log2(right - left + 1);                                  \
+    while (right > left) {                                                          \
+        if (right - left + 1 <= MYSORT_INSERTION_CUTOFF) {                          \
+            prefix##_insertion_sort(a, left, right, ctx);                           \
+            return;                                                                 \
+        }                                                                           \
+        if (depth-- == 0) {                                                         \
+            prefix##_heap_sort(a, left, right, ctx);                                \
+            return;                                                                 \
+        }                                                                           \
+        int p = prefix##_partition(a, left, right, ctx);                            \
+        if (p == k) return;                                                         \
+        if (k < p)                                                                  \
+            right = p - 1;                                                          \
+        else                                                                        \
+            left = p + 1;                                                           \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static inline void prefix##_partial_sort(T *a, int left, int right, int k,        \
+                                         const void *ctx) {                         \
+    int n = right - left + 1;                                                       \
+    if (k > n) k = n;                                                               \
+    if (k <= 0) return;                                                             \
+    for (int i = k / 2 - 1; i >= 0; --i)                                            \
+        prefix##_sift_down(a, left, i, k, ctx);                                     \
+    for (int i = left + k; i <= right; i++) {                                       \
+        if (LESS(a[i], a[left], ctx)) {                                             \
+            prefix##_swap(&a[i], &a[left]);                                         \
+            prefix##_sift_down(a, left, 0, k, ctx);                                 \
+        }                                                                           \
+    }                                                                               \
+    for (int end = k - 1; end > 0; --end) {                                         \
+        prefix##_swap(&a[left], &a[left + end]);                                    \
+        prefix##_sift_down(a, left, 0, end, ctx);                                   \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static inline void prefix##_sort(T *a, int n, const void *ctx) {                    \
+    if (a && n > 1)                                                                 \
+        prefix##_intro_sort(a, 0, n - 1, 2 * mysort_log2(n), ctx);                  \
+}                                                                                   \
+                                                                                    \
+static inline void prefix##_sort3(T *a, int n, const void *ctx) {                   \
+    if (a && n > 1)                                                                 \
+        prefix##_intro_sort3(a, 0, n - 1, 2 * mysort_log2(n), ctx);                 \
+}
+
+#endif
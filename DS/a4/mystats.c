@@ -0,0 +1,418 @@
+/*
+ * Mergeable score statistics.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "mystats.h"
+#include "mysort_template.h"
+
+#define MOMENTS_BLOCK 4096
+#define PARALLEL_MIN_CHUNK (1 << 18)
+#define TDIGEST_PI 3.14159265358979323846
+
+/**
+ * Add one score to the moments with Welford's update, which stays accurate
+ * where the naive sum of squares cancels.
+ *
+ * @param *m - moments to update.
+ * @param x - the score.
+ */
+void moments_add(MOMENTS *m, float x) {
+    m->count++;
+    double delta = x - m->mean;
+    m->mean += delta / m->count;
+    m->m2 += delta * (x - m->mean);
+}
+
+/**
+ * Take back one score previously added, inverting Welford's update. Rounding
+ * can leave m2 a hair below zero after many removals, so it is clamped; the
+ * moments reset exactly when the last score goes.
+ *
+ * @param *m - moments to update.
+ * @param x - the score, which must be among those added.
+ */
+void moments_remove(MOMENTS *m, float x) {
+    if (m->count <= 1) {
+        m->count = 0;
+        m->mean = m->m2 = 0.0;
+        return;
+    }
+    double delta = x - m->mean;
+    m->count--;
+    m->mean -= delta / m->count;
+    m->m2 -= delta * (x - m->mean);
+    if (m->m2 < 0.0) m->m2 = 0.0;
+}
+
+/**
+ * Combine the moments of two disjoint sets of scores into dst:
+ *   mean = mean_a + delta * n_b / n
+ *   m2   = m2_a + m2_b + delta^2 * n_a * n_b / n,   delta = mean_b - mean_a
+ *
+ * @param *dst - moments of the first set, replaced by those of the union.
+ * @param *src - moments of the second set.
+ */
+void moments_merge(MOMENTS *dst, const MOMENTS *src) {
+    if (src->count == 0) return;
+    if (dst->count == 0) {
+        *dst = *src;
+        return;
+    }
+    double na = (double)dst->count, nb = (double)src->count;
+    double n = na + nb;
+    double delta = src->mean - dst->mean;
+    dst->mean += delta * nb / n;
+    dst->m2 += src->m2 + delta * delta * na * nb / n;
+    dst->count += src->count;
+}
+
+/*
+ * Moments of one block of at most MOMENTS_BLOCK scores: two passes over data
+ * that is already in cache, the sum and then the squared deviations from the
+ * block mean, each accumulated in four float lanes.
+ */
+static MOMENTS block_moments(const float *x, int n) {
+    MOMENTS m = {n, 0.0, 0.0};
+    int i = 0;
+    float sum = 0.0f, sq = 0.0f;
+
+#ifdef __SSE2__
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4)
+        acc = _mm_add_ps(acc, _mm_loadu_ps(x + i));
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; i++) sum += x[i];
+    float mean = sum / n;
+
+    i = 0;
+#ifdef __SSE2__
+    __m128 mv = _mm_set1_ps(mean);
+    acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(x + i), mv);
+        acc = _mm_add_ps(acc, _mm_mul_ps(d, d));
+    }
+    _mm_storeu_ps(lanes, acc);
+    sq = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; i++) {
+        float d = x[i] - mean;
+        sq += d * d;
+    }
+
+    m.mean = mean;
+    m.m2 = sq;
+    return m;
+}
+
+/**
+ * Compute the moments of an array of scores on the calling thread. The array
+ * is processed in blocks of 4096 with SIMD sums, and the blocks are combined
+ * with moments_merge in double precision.
+ *
+ * @param *x - array of scores.
+ * @param n - number of scores.
+ * @return - the moments of x[0..n-1].
+ */
+MOMENTS moments_of(const float *x, long long n) {
+    MOMENTS m = {0, 0.0, 0.0};
+    for (long long i = 0; i < n; i += MOMENTS_BLOCK) {
+        int len = n - i < MOMENTS_BLOCK ? (int)(n - i) : MOMENTS_BLOCK;
+        MOMENTS b = block_moments(x + i, len);
+        moments_merge(&m, &b);
+    }
+    return m;
+}
+
+typedef struct {
+    const float *x;
+    long long n;
+    MOMENTS result;
+} MOMENTS_TASK;
+
+static void *moments_worker(void *arg) {
+    MOMENTS_TASK *t = arg;
+    t->result = moments_of(t->x, t->n);
+    return NULL;
+}
+
+/**
+ * Compute the moments of an array of scores using several threads. The array
+ * is split into one contiguous chunk per thread (at least 2^18 scores each),
+ * the calling thread takes the first chunk, and the per-chunk moments are
+ * merged in chunk order, so the result does not depend on thread timing.
+ *
+ * @param *x - array of scores.
+ * @param n - number of scores.
+ * @param nthreads - number of threads to use, <= 0 for one per online CPU.
+ * @return - the moments of x[0..n-1].
+ */
+MOMENTS moments_parallel(const float *x, long long n, int nthreads) {
+    if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > n / PARALLEL_MIN_CHUNK) nthreads = (int)(n / PARALLEL_MIN_CHUNK);
+    if (nthreads <= 1) return moments_of(x, n);
+
+    MOMENTS_TASK *tasks = malloc(nthreads * sizeof *tasks);
+    pthread_t *threads = malloc(nthreads * sizeof *threads);
+    int *started = calloc(nthreads, sizeof *started);
+    if (!tasks || !threads || !started) {
+        free(tasks);
+        free(threads);
+        free(started);
+        return moments_of(x, n);
+    }
+
+    long long chunk = n / nthreads;
+    for (int i = 0; i < nthreads; i++) {
+        tasks[i].x = x + i * chunk;
+        tasks[i].n = (i == nthreads - 1) ? n - i * chunk : chunk;
+    }
+    for (int i = 1; i < nthreads; i++)
+        started[i] = pthread_create(&threads[i], NULL, moments_worker, &tasks[i]) == 0;
+    moments_worker(&tasks[0]);
+
+    MOMENTS m = tasks[0].result;
+    for (int i = 1; i < nthreads; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            moments_worker(&tasks[i]);
+        moments_merge(&m, &tasks[i].result);
+    }
+
+    free(tasks);
+    free(threads);
+    free(started);
+    return m;
+}
+
+/**
+ * Population standard deviation of the scores described by the moments.
+ *
+ * @param *m - moments.
+ * @return - sqrt(m2 / count), or 0 if count is 0.
+ */
+double moments_stddev(const MOMENTS *m) {
+    return m->count > 0 ? sqrt(m->m2 / m->count) : 0.0;
+}
+
+
+
+// (mean, weight) pairs ordered by mean, for compressing a digest
+typedef struct {
+    double mean;
+    double weight;
+} CENTROID;
+
+#define CENTROID_LESS(x, y, ctx) ((x).mean < (y).mean)
+
+MYSORT_DEFINE(centroid, CENTROID, CENTROID_LESS)
+
+/**
+ * Allocate an empty t-digest. All memory is allocated here; adding scores
+ * never allocates.
+ *
+ * @param compression - accuracy/size trade-off, <= 0 for the default (200).
+ * @return - the digest, or NULL if out of memory.
+ */
+TDIGEST *tdigest_create(double compression) {
+    if (compression <= 0) compression = TDIGEST_DEFAULT_COMPRESSION;
+    TDIGEST *td = calloc(1, sizeof *td);
+    if (!td) return NULL;
+
+    td->compression = compression;
+    td->cap = (int)ceil(compression) + 10;
+    td->bufcap = 5 * td->cap;
+    td->mean = malloc(td->cap * sizeof *td->mean);
+    td->weight = malloc(td->cap * sizeof *td->weight);
+    td->buf_mean = malloc(td->bufcap * sizeof *td->buf_mean);
+    td->buf_weight = malloc(td->bufcap * sizeof *td->buf_weight);
+    td->scratch = malloc((td->cap + td->bufcap) * sizeof(CENTROID));
+    td->min = INFINITY;
+    td->max = -INFINITY;
+    if (!td->mean || !td->weight || !td->buf_mean || !td->buf_weight || !td->scratch) {
+        tdigest_free(td);
+        return NULL;
+    }
+    return td;
+}
+
+/**
+ * Release a t-digest.
+ *
+ * @param *td - digest, may be NULL.
+ */
+void tdigest_free(TDIGEST *td) {
+    if (!td) return;
+    free(td->mean);
+    free(td->weight);
+    free(td->buf_mean);
+    free(td->buf_weight);
+    free(td->scratch);
+    free(td);
+}
+
+// k1 scale function and its inverse: k(q) = compression / (2 pi) * asin(2q - 1)
+static double scale_k(double q, double compression) {
+    return compression / (2 * TDIGEST_PI) * asin(2 * q - 1);
+}
+
+static double scale_q(double k, double compression) {
+    return (sin(k * 2 * TDIGEST_PI / compression) + 1) / 2;
+}
+
+/*
+ * Largest quantile the centroid starting at quantile q may reach: one unit
+ * of k further. k tops out at compression / 4, where q = 1; past it sin()
+ * would turn back down, so the limit is clamped there.
+ */
+static double scale_limit(double q, double compression) {
+    double k = scale_k(q, compression) + 1;
+    return k >= compression / 4 ? 1.0 : scale_q(k, compression);
+}
+
+/*
+ * Merge the buffered points into the centroids: sort everything by mean, then
+ * sweep left to right, folding the next item into the current centroid while
+ * the centroid spans less than one unit of k. The k1 scale yields at most
+ * about compression / 2 centroids; the last slot of td->mean also absorbs
+ * whatever is left, so rounding can never write past td->cap.
+ */
+static void tdigest_compress(TDIGEST *td) {
+    if (td->nbuf == 0) return;
+
+    CENTROID *all = td->scratch;
+    int n = 0;
+    double total = td->total;
+    for (int i = 0; i < td->ncentroids; i++, n++) {
+        all[n].mean = td->mean[i];
+        all[n].weight = td->weight[i];
+    }
+    for (int i = 0; i < td->nbuf; i++, n++) {
+        all[n].mean = td->buf_mean[i];
+        all[n].weight = td->buf_weight[i];
+        total += td->buf_weight[i];
+    }
+    centroid_sort(all, n, NULL);
+
+    int out = 0;
+    double so_far = 0;
+    double limit = total * scale_limit(0, td->compression);
+    CENTROID cur = all[0];
+    for (int i = 1; i < n; i++) {
+        if (so_far + cur.weight + all[i].weight <= limit || out == td->cap - 1) {
+            cur.weight += all[i].weight;
+            cur.mean += (all[i].mean - cur.mean) * all[i].weight / cur.weight;
+        } else {
+            td->mean[out] = cur.mean;
+            td->weight[out] = cur.weight;
+            out++;
+            so_far += cur.weight;
+            limit = total * scale_limit(so_far / total, td->compression);
+            cur = all[i];
+        }
+    }
+    td->mean[out] = cur.mean;
+    td->weight[out] = cur.weight;
+    td->ncentroids = out + 1;
+    td->nbuf = 0;
+    td->total = total;
+}
+
+static void tdigest_push(TDIGEST *td, double mean, double weight) {
+    if (td->nbuf == td->bufcap) tdigest_compress(td);
+    td->buf_mean[td->nbuf] = mean;
+    td->buf_weight[td->nbuf] = weight;
+    td->nbuf++;
+}
+
+/**
+ * Add one score to the digest. Amortized O(log compression).
+ *
+ * @param *td - digest.
+ * @param x - the score; NaN is ignored.
+ */
+void tdigest_add(TDIGEST *td, float x) {
+    if (isnan(x)) return;
+    if (x < td->min) td->min = x;
+    if (x > td->max) td->max = x;
+    tdigest_push(td, x, 1.0);
+}
+
+/**
+ * Add every centroid and buffered point of src to dst. The result describes
+ * the union of both inputs with the same error bound as a single digest.
+ *
+ * @param *dst - digest to add to.
+ * @param *src - digest to read; unchanged.
+ */
+void tdigest_merge(TDIGEST *dst, const TDIGEST *src) {
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+    for (int i = 0; i < src->ncentroids; i++)
+        tdigest_push(dst, src->mean[i], src->weight[i]);
+    for (int i = 0; i < src->nbuf; i++)
+        tdigest_push(dst, src->buf_mean[i], src->buf_weight[i]);
+}
+
+/**
+ * Number of scores the digest describes.
+ *
+ * @param *td - digest.
+ * @return - the count.
+ */
+long long tdigest_count(TDIGEST *td) {
+    tdigest_compress(td);
+    return (long long)td->total;
+}
+
+/**
+ * Estimate the score at quantile q by interpolating between the centers of
+ * the centroids around rank q * count; the outer half-centroids interpolate
+ * to the observed min and max.
+ *
+ * @param *td - digest; buffered points are merged first.
+ * @param q - quantile in [0, 1], clamped.
+ * @return - the estimated score, or NAN if the digest is empty.
+ */
+double tdigest_quantile(TDIGEST *td, double q) {
+    tdigest_compress(td);
+    int n = td->ncentroids;
+    if (n == 0) return NAN;
+    if (q < 0) q = 0;
+    if (q > 1) q = 1;
+    if (n == 1) return td->mean[0];
+
+    double total = td->total;
+    double index = q * total;
+    if (index <= td->weight[0] / 2) {
+        double w = td->weight[0] / 2;
+        return td->min + (td->mean[0] - td->min) * index / w;
+    }
+    if (index >= total - td->weight[n - 1] / 2) {
+        double w = td->weight[n - 1] / 2;
+        return td->max - (td->max - td->mean[n - 1]) * (total - index) / w;
+    }
+
+    double so_far = td->weight[0] / 2;
+    for (int i = 0; i < n - 1; i++) {
+        double dw = (td->weight[i] + td->weight[i + 1]) / 2;
+        if (so_far + dw >= index) {
+            double t = (index - so_far) / dw;
+            return td->mean[i] + (td->mean[i + 1] - td->mean[i]) * t;
+        }
+        so_far += dw;
+    }
+    return td->mean[n - 1];
+}
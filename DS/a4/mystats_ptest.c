@@ -0,0 +1,125 @@
+/*
+--------------------------------------------------
+Project: a4
+File:    mystats_ptest.c
+About:   public test driver for mystats
+Version: 2026-10-18
+--------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mystats.h"
+
+static float scores[] = {10, 20, 30, 40, 50, 60, 70, 80, 90, 100};
+
+void print_moments(const char *label, MOMENTS m) {
+	printf("%-22s count=%lld mean=%.2f stddev=%.2f\n", label, m.count, m.mean,
+			moments_stddev(&m));
+}
+
+void test_moments() {
+	printf("------------------\n");
+	printf("Test: moments\n\n");
+	int n = sizeof scores / sizeof *scores;
+
+	MOMENTS m = {0, 0.0, 0.0};
+	for (int i = 0; i < n; i++)
+		moments_add(&m, scores[i]);
+	print_moments("moments_add:", m);
+
+	print_moments("moments_of:", moments_of(scores, n));
+
+	MOMENTS a = moments_of(scores, 3);
+	MOMENTS b = moments_of(scores + 3, n - 3);
+	moments_merge(&a, &b);
+	print_moments("moments_merge(3, 7):", a);
+	printf("\n");
+}
+
+void test_moments_parallel() {
+	printf("------------------\n");
+	printf("Test: moments_parallel\n\n");
+	int n = 2000000;
+	float *x = malloc(n * sizeof *x);
+	if (!x) return;
+	for (int i = 0; i < n; i++)
+		x[i] = (i % 201) / 2.0f;
+
+	MOMENTS s = moments_of(x, n);
+	MOMENTS p = moments_parallel(x, n, 4);
+	print_moments("moments_of:", s);
+	print_moments("moments_parallel(4):", p);
+	free(x);
+	printf("\n");
+}
+
+void test_tdigest() {
+	printf("------------------\n");
+	printf("Test: tdigest\n\n");
+	int n = 1000000, shards = 4;
+	TDIGEST *one = tdigest_create(0);
+	TDIGEST *all = tdigest_create(0);
+	TDIGEST *part[4];
+	for (int s = 0; s < shards; s++)
+		part[s] = tdigest_create(0);
+	if (!one || !all || !part[0] || !part[1] || !part[2] || !part[3]) return;
+
+	// i * 7919 mod n visits every rank once in scrambled order; the exact
+	// q-quantile of 0..n-1 is q * n
+	for (int i = 0; i < n; i++) {
+		float x = (float)(((long long)i * 7919) % n);
+		tdigest_add(one, x);
+		tdigest_add(part[i % shards], x);
+	}
+	for (int s = 0; s < shards; s++)
+		tdigest_merge(all, part[s]);
+
+	printf("count: %lld, merged count: %lld\n", tdigest_count(one), tdigest_count(all));
+	double qs[] = {0.001, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999};
+	for (int i = 0; i < (int)(sizeof qs / sizeof *qs); i++) {
+		double e1 = (tdigest_quantile(one, qs[i]) - qs[i] * n) / n;
+		double e2 = (tdigest_quantile(all, qs[i]) - qs[i] * n) / n;
+		printf("q=%-6g rank error: single %s, merged %s\n", qs[i],
+				e1 < 0.002 && e1 > -0.002 ? "ok" : "FAIL",
+				e2 < 0.002 && e2 > -0.002 ? "ok" : "FAIL");
+	}
+	for (int s = 0; s < shards; s++)
+		tdigest_free(part[s]);
+	tdigest_free(one);
+	tdigest_free(all);
+	printf("\n");
+}
+
+void test_tdigest_large() {
+	printf("------------------\n");
+	printf("Test: tdigest, 10M skewed scores\n\n");
+	int n = 10000000;
+	TDIGEST *td = tdigest_create(0);
+	if (!td) return;
+
+	// rank r in scrambled order maps to 100 * (r / n)^4, so most scores bunch
+	// near 0 and the exact q-quantile is 100 * q^4
+	for (int i = 0; i < n; i++) {
+		double u = (double)(((long long)i * 7919) % n) / n;
+		tdigest_add(td, (float)(100 * u * u * u * u));
+	}
+	printf("count: %lld, centroids: %d of %d\n", tdigest_count(td), td->ncentroids, td->cap);
+	double qs[] = {0.001, 0.01, 0.1, 0.5, 0.9, 0.99, 0.999, 0.9999};
+	for (int i = 0; i < (int)(sizeof qs / sizeof *qs); i++) {
+		double v = tdigest_quantile(td, qs[i]);
+		double e = (v > 0 ? pow(v / 100, 0.25) : 0) - qs[i];
+		printf("q=%-6g rank error: %s\n", qs[i], e < 0.002 && e > -0.002 ? "ok" : "FAIL");
+	}
+	tdigest_free(td);
+	printf("\n");
+}
+
+int main(int argc, char *args[]) {
+	test_moments();
+	test_moments_parallel();
+	test_tdigest();
+	test_tdigest_large();
+	return 0;
+}